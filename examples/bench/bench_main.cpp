@@ -0,0 +1,624 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "fonts/u8g2_font_6x10_ascii.hpp"
+#include "glyph_cache.hpp"
+#include "headless_backend.hpp"
+#include "mock_pixels.hpp"
+#include "present.hpp"
+#include "widget.hpp"
+
+// Prints one JSON object per line:
+//   {"name":..., "iterations":..., "ns_per_op":..., "bytes_per_op":...}
+// bytes_per_op counts framebuffer bytes the operation covers, or bytes handed to the
+// backend for present cases. An optional argument keeps only names containing it.
+
+namespace
+{
+
+using namespace LibXR::MonoGL;
+
+constexpr uint16_t WIDTH = 256U;
+constexpr uint16_t HEIGHT = 64U;
+constexpr std::size_t FRAME_BYTES = static_cast<std::size_t>(WIDTH / 8U) * HEIGHT;
+constexpr double MIN_SECONDS = 0.05;
+
+const char* g_filter = nullptr;
+volatile uint8_t g_sink = 0;
+
+// Bytes of a row-major framebuffer that hold rect.
+std::size_t rect_bytes(Rect rect) noexcept
+{
+  const Rect CLIPPED = intersect_rect(rect, Rect{0, 0, WIDTH, HEIGHT});
+  if (rect_empty(CLIPPED))
+  {
+    return 0;
+  }
+  const ByteWindow WINDOW = layout_byte_window(CLIPPED, PixelLayout::ROW_MAJOR_MSB);
+  return static_cast<std::size_t>(WINDOW.byte_end - WINDOW.byte_begin) *
+         (WINDOW.line_end - WINDOW.line_begin);
+}
+
+// Doubles the iteration count until one run takes MIN_SECONDS.
+template <typename Fn>
+void run(const char* name, std::size_t bytes_per_op, Fn&& fn)
+{
+  if (g_filter != nullptr && std::strstr(name, g_filter) == nullptr)
+  {
+    return;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  uint64_t iterations = 16;
+  double seconds = 0.0;
+  while (true)
+  {
+    const Clock::time_point START = Clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+      fn(static_cast<uint32_t>(i));
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - START).count();
+    if (seconds >= MIN_SECONDS || iterations >= (uint64_t{1} << 40))
+    {
+      break;
+    }
+    iterations *= 2U;
+  }
+
+  std::printf(
+      "{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,\"bytes_per_op\":%zu}\n",
+      name, static_cast<unsigned long long>(iterations),
+      seconds * 1e9 / static_cast<double>(iterations), bytes_per_op);
+}
+
+struct NullBackend
+{
+  bool async{false};
+  bool hw_scroll{false};
+  uint16_t max_chunk_bytes{0};
+  std::size_t bytes{0};
+  std::size_t total_bytes{0};  // Summed over presents, for chunked frames.
+
+  LibXR::ErrorCode Init(const DisplayConfig&) noexcept { return LibXR::ErrorCode::OK; }
+  BackendCaps Caps() const noexcept
+  {
+    return BackendCaps{
+        true, false, false, async, DirtyRegion::MAX_RECTS, hw_scroll, max_chunk_bytes};
+  }
+  LibXR::ErrorCode Present(const FrameView& frame, PresentMode mode) noexcept
+  {
+    bytes = 0;
+    if (mode == PresentMode::FULL)
+    {
+      bytes = static_cast<std::size_t>(frame.stride_bytes) * frame.row_count;
+    }
+    else
+    {
+      for (uint8_t i = 0; i < frame.dirty_count; ++i)
+      {
+        bytes += rect_bytes(frame.dirty_rects[i]);
+      }
+    }
+    total_bytes += bytes;
+    g_sink = static_cast<uint8_t>(g_sink + frame.bits[0]);
+    return LibXR::ErrorCode::OK;
+  }
+  LibXR::ErrorCode SetPowerSave(bool) noexcept { return LibXR::ErrorCode::OK; }
+  LibXR::ErrorCode SetContrast(uint8_t) noexcept { return LibXR::ErrorCode::OK; }
+  LibXR::ErrorCode Scroll(int16_t) noexcept { return LibXR::ErrorCode::OK; }
+};
+
+using BenchPresent = Present<NullBackend, FRAME_BYTES>;
+
+DisplayConfig bench_config() noexcept
+{
+  DisplayConfig config{};
+  config.width = WIDTH;
+  config.height = HEIGHT;
+  return config;
+}
+
+void bench_surface()
+{
+  static uint8_t bits[FRAME_BYTES];
+  Surface surface{};
+  surface.Bind(bits, Size{WIDTH, HEIGHT});
+  const auto CONSUME = [&]()
+  {
+    surface.ClearDirtyRect();
+    g_sink = static_cast<uint8_t>(g_sink + bits[FRAME_BYTES / 2U]);
+  };
+
+  run("clear", FRAME_BYTES,
+      [&](uint32_t i)
+      {
+        surface.Clear((i & 1U) != 0U ? Color::WHITE : Color::BLACK);
+        CONSUME();
+      });
+
+  run("hline/aligned_64", rect_bytes(Rect{64, 0, 64, 1}),
+      [&](uint32_t i)
+      {
+        surface.DrawHLine(Point{64, static_cast<int16_t>(i & 63U)}, 64, Color::WHITE);
+        CONSUME();
+      });
+  run("hline/unaligned_61", rect_bytes(Rect{67, 0, 61, 1}),
+      [&](uint32_t i)
+      {
+        surface.DrawHLine(Point{67, static_cast<int16_t>(i & 63U)}, 61, Color::WHITE);
+        CONSUME();
+      });
+  run("vline/64", rect_bytes(Rect{0, 0, 1, 64}),
+      [&](uint32_t i)
+      {
+        surface.DrawVLine(Point{static_cast<int16_t>(i & 255U), 0}, 64, Color::WHITE);
+        CONSUME();
+      });
+
+  run("fill_rect/aligned_128x32", rect_bytes(Rect{64, 16, 128, 32}),
+      [&](uint32_t)
+      {
+        surface.FillRect(Rect{64, 16, 128, 32}, Color::WHITE);
+        CONSUME();
+      });
+  run("fill_rect/unaligned_125x32", rect_bytes(Rect{67, 16, 125, 32}),
+      [&](uint32_t)
+      {
+        surface.FillRect(Rect{67, 16, 125, 32}, Color::WHITE);
+        CONSUME();
+      });
+  run("fill_rect/xor_unaligned_125x32", rect_bytes(Rect{67, 16, 125, 32}),
+      [&](uint32_t)
+      {
+        surface.FillRect(Rect{67, 16, 125, 32}, Color::WHITE, RasterOp::XOR);
+        CONSUME();
+      });
+  run("fill_rect/narrow_3x32", rect_bytes(Rect{13, 16, 3, 32}),
+      [&](uint32_t)
+      {
+        surface.FillRect(Rect{13, 16, 3, 32}, Color::WHITE);
+        CONSUME();
+      });
+
+  run("scroll/full_by_1", FRAME_BYTES,
+      [&](uint32_t)
+      {
+        surface.ScrollRect(Rect{0, 0, WIDTH, HEIGHT}, 0, -1);
+        CONSUME();
+      });
+  run("scroll/unaligned_125x32_by_3", rect_bytes(Rect{67, 16, 125, 32}),
+      [&](uint32_t i)
+      {
+        surface.ScrollRect(Rect{67, 16, 125, 32}, (i & 1U) != 0U ? 3 : -3, 0);
+        CONSUME();
+      });
+
+  run("line/diagonal_256x64", rect_bytes(Rect{0, 0, WIDTH, HEIGHT}),
+      [&](uint32_t)
+      {
+        surface.DrawLine(Point{0, 0}, Point{WIDTH - 1, HEIGHT - 1}, Color::WHITE);
+        CONSUME();
+      });
+  run("line/clipped_8000x2000", rect_bytes(Rect{0, 0, WIDTH, HEIGHT}),
+      [&](uint32_t)
+      {
+        surface.DrawLine(Point{-3872, -968}, Point{4128, 1032}, Color::WHITE);
+        CONSUME();
+      });
+  static Point trace[129];
+  for (std::size_t i = 0; i < 129U; ++i)
+  {
+    trace[i] = Point{static_cast<int16_t>(i * 2U),
+                     static_cast<int16_t>(32 + ((i * 37U) % 61U) / 2 - 15)};
+  }
+  run("polyline/128_segments", rect_bytes(Rect{0, 0, WIDTH, HEIGHT}),
+      [&](uint32_t)
+      {
+        surface.DrawPolyline(trace, 129, Color::WHITE);
+        CONSUME();
+      });
+  run("line/128_segments", rect_bytes(Rect{0, 0, WIDTH, HEIGHT}),
+      [&](uint32_t)
+      {
+        for (std::size_t i = 1; i < 129U; ++i)
+        {
+          surface.DrawLine(trace[i - 1U], trace[i], Color::WHITE);
+        }
+        CONSUME();
+      });
+  static uint8_t bars[64];
+  for (std::size_t i = 0; i < sizeof(bars); ++i)
+  {
+    bars[i] = static_cast<uint8_t>((i * 29U) % 64U);
+  }
+  run("histogram/64x4", rect_bytes(Rect{0, 0, WIDTH, HEIGHT}),
+      [&](uint32_t)
+      {
+        surface.DrawHistogram(Rect{0, 0, WIDTH, HEIGHT}, bars, 64, 4, Color::WHITE);
+        CONSUME();
+      });
+
+  run("circle/r30", rect_bytes(Rect{98, 2, 61, 61}),
+      [&](uint32_t)
+      {
+        surface.DrawCircle(Point{128, 32}, 30, Color::WHITE);
+        CONSUME();
+      });
+  run("fill_circle/r30", rect_bytes(Rect{98, 2, 61, 61}),
+      [&](uint32_t)
+      {
+        surface.FillCircle(Point{128, 32}, 30, Color::WHITE);
+        CONSUME();
+      });
+  run("ellipse/60x20", rect_bytes(Rect{68, 12, 121, 41}),
+      [&](uint32_t)
+      {
+        surface.DrawEllipse(Point{128, 32}, 60, 20, Color::WHITE);
+        CONSUME();
+      });
+  run("fill_round_rect/125x32_r6", rect_bytes(Rect{67, 16, 125, 32}),
+      [&](uint32_t)
+      {
+        surface.FillRoundRect(Rect{67, 16, 125, 32}, 6, Color::WHITE);
+        CONSUME();
+      });
+
+  static uint8_t image[(64U / 8U) * 32U];
+  for (std::size_t i = 0; i < sizeof(image); ++i)
+  {
+    image[i] = static_cast<uint8_t>(i * 37U + 11U);
+  }
+  run("bitmap/transparent_64x32_unaligned", rect_bytes(Rect{13, 16, 64, 32}),
+      [&](uint32_t)
+      {
+        surface.DrawBitmap(Point{13, 16}, image, Size{64, 32}, Color::WHITE);
+        CONSUME();
+      });
+  BitmapStyle opaque{};
+  opaque.mode = BitmapMode::OPAQUE;
+  run("bitmap/opaque_64x32_aligned", rect_bytes(Rect{16, 16, 64, 32}),
+      [&](uint32_t)
+      {
+        surface.DrawBitmap(Point{16, 16}, image, Size{64, 32}, opaque);
+        CONSUME();
+      });
+
+  // A 128x64 gradient with noise, as a product photo might be.
+  static uint8_t gray[128U * 64U];
+  for (uint32_t i = 0; i < sizeof(gray); ++i)
+  {
+    gray[i] = static_cast<uint8_t>((i % 128U) * 2U + ((i * 2654435761U) >> 29U));
+  }
+  static int16_t errors[129];
+  const DitherMode DITHERS[] = {DitherMode::THRESHOLD, DitherMode::ORDERED,
+                                DitherMode::FLOYD_STEINBERG};
+  const char* const GRAY_NAMES[] = {"gray/threshold_128x64", "gray/ordered_128x64",
+                                    "gray/floyd_steinberg_128x64"};
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    GrayStyle gray_style{};
+    gray_style.dither = DITHERS[i];
+    gray_style.errors = errors;
+    gray_style.error_count = static_cast<uint16_t>(sizeof(errors) / sizeof(errors[0]));
+    run(GRAY_NAMES[i], rect_bytes(Rect{64, 0, 128, 64}),
+        [&](uint32_t)
+        {
+          surface.DrawGray8(Point{64, 0}, gray, Size{128, 64}, gray_style);
+          CONSUME();
+        });
+  }
+
+  static StaticGlyphCache<> cache{};
+  const char* const TEXT = "The quick brown fox 0123";
+  TextStyle style{};
+  style.font = &DesktopMock::U8G2_FONT_6X10_ASCII;
+  const uint8_t SCALES[] = {1, 2, 3};
+  for (const uint8_t SCALE : SCALES)
+  {
+    for (int cached = 0; cached < 2; ++cached)
+    {
+      if (SCALE == 1 && cached != 0)
+      {
+        continue;
+      }
+      style.scale_x = SCALE;
+      style.scale_y = SCALE;
+      style.glyph_cache = (cached != 0) ? &cache : nullptr;
+      char name[48];
+      std::snprintf(name, sizeof(name), "text/24_chars_scale%u%s",
+                    static_cast<unsigned>(SCALE), (cached != 0) ? "_cached" : "");
+      const Rect BOX{0, 0, static_cast<uint16_t>(24U * 6U * SCALE),
+                     static_cast<uint16_t>(10U * SCALE)};
+      run(name, rect_bytes(BOX),
+          [&](uint32_t)
+          {
+            surface.DrawTextTopLeft(Point{0, 0}, TEXT, style);
+            CONSUME();
+          });
+    }
+  }
+
+  // Wrapping every frame against drawing lines laid out once.
+  const char* const PARAGRAPH =
+      "Battery low. Connect the charger or the device shuts down in five minutes.";
+  style.scale_x = 1;
+  style.scale_y = 1;
+  style.glyph_cache = nullptr;
+  TextLine lines[8]{};
+  const Rect BOX{0, 0, 128, 64};
+  run("text/layout_74_chars", 0,
+      [&](uint32_t)
+      {
+        const uint16_t COUNT = layout_text(PARAGRAPH, BOX.w, style, lines, 8);
+        g_sink = static_cast<uint8_t>(g_sink + COUNT);
+      });
+  const uint16_t LINE_COUNT = layout_text(PARAGRAPH, BOX.w, style, lines, 8);
+  run("text/lines_74_chars_centered", rect_bytes(BOX),
+      [&](uint32_t)
+      {
+        surface.DrawTextLines(BOX, lines, LINE_COUNT, style, TextAlign::CENTER);
+        CONSUME();
+      });
+
+  // One value of a retained screen changing every frame.
+  static Scene<4> scene{};
+  static const char* const ITEMS[] = {"Voltage", "Current", "Power", "Setup"};
+  scene.AddLabel(Rect{0, 0, 128, 12}, "Status", style, TextAlign::CENTER);
+  const WidgetId VALUE = scene.AddValue(Rect{72, 16, 56, 12}, 0, 2, " V", style);
+  scene.AddBar(Rect{0, 30, 128, 8}, 0, 0, 100);
+  scene.AddList(Rect{0, 40, 128, 24}, ITEMS, 4, style);
+  scene.Render(surface);
+  run("scene/value_update", rect_bytes(Rect{72, 16, 56, 12}),
+      [&](uint32_t i)
+      {
+        scene.SetValue(VALUE, static_cast<int32_t>(i & 0x3FFU));
+        scene.Render(surface);
+        CONSUME();
+      });
+}
+
+void bench_present_case(const char* name, bool async, PresentMode mode, Rect damage)
+{
+  NullBackend backend{};
+  backend.async = async;
+  BenchPresent presenter(backend, bench_config());
+  const auto FRAME = [&]()
+  {
+    presenter.GetSurface().FillRect(damage, Color::WHITE, RasterOp::XOR);
+    (void)presenter.PresentFrame(mode);
+    if (async)
+    {
+      (void)presenter.OnTransferDone();
+    }
+  };
+
+  // Warm up past the initial full present (and DIFF's first reference frame), then
+  // keep what the backend was given per frame.
+  for (int i = 0; i < 3; ++i)
+  {
+    FRAME();
+  }
+  const std::size_t BYTES = presenter.GetBackend().bytes;
+
+  run(name, BYTES, [&](uint32_t) { FRAME(); });
+}
+
+// A log view: scroll up one text line, draw the new line, present.
+void bench_scroll_case(const char* name, bool hw_scroll)
+{
+  NullBackend backend{};
+  backend.hw_scroll = hw_scroll;
+  BenchPresent presenter(backend, bench_config());
+  const auto FRAME = [&]()
+  {
+    (void)presenter.ScrollFrame(-8);
+    presenter.GetSurface().FillRect(Rect{0, HEIGHT - 8, 100, 7}, Color::WHITE);
+    (void)presenter.PresentFrame(PresentMode::DIRTY);
+  };
+
+  for (int i = 0; i < 3; ++i)
+  {
+    FRAME();
+  }
+  const std::size_t BYTES = presenter.GetBackend().bytes;
+  run(name, BYTES, [&](uint32_t) { FRAME(); });
+}
+
+// A panel that finishes one transfer per two drawn frames. Two buffers reject every
+// other present with BUSY; three keep the newest frame in the mailbox.
+template <uint8_t kBuffers>
+void bench_slow_panel_case(const char* name, Rect damage)
+{
+  NullBackend backend{};
+  backend.async = true;
+  Present<NullBackend, FRAME_BYTES, kBuffers> presenter(backend, bench_config());
+  const auto FRAME = [&](uint32_t i)
+  {
+    presenter.GetSurface().FillRect(damage, Color::WHITE, RasterOp::XOR);
+    (void)presenter.PresentFrame(PresentMode::DIRTY);
+    if ((i & 1U) != 0U)
+    {
+      (void)presenter.OnTransferDone();
+    }
+  };
+
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    FRAME(i);
+  }
+  run(name, presenter.GetBackend().bytes, FRAME);
+}
+
+// Full frames through a backend that takes max_chunk_bytes per transfer.
+void bench_chunk_case(const char* name, bool async, uint16_t max_chunk_bytes)
+{
+  NullBackend backend{};
+  backend.async = async;
+  backend.max_chunk_bytes = max_chunk_bytes;
+  BenchPresent presenter(backend, bench_config());
+  const auto FRAME = [&]()
+  {
+    presenter.GetSurface().FillRect(Rect{0, 0, 8, 8}, Color::WHITE, RasterOp::XOR);
+    (void)presenter.PresentFrame(PresentMode::FULL);
+    while (presenter.IsTransferInProgress())
+    {
+      (void)presenter.OnTransferDone();
+    }
+  };
+
+  FRAME();
+  const std::size_t BEFORE = presenter.GetBackend().total_bytes;
+  FRAME();
+  const std::size_t BYTES = presenter.GetBackend().total_bytes - BEFORE;
+  run(name, BYTES, [&](uint32_t) { FRAME(); });
+}
+
+// Two displays on one bus, each updating a small area per frame.
+void bench_bus_case(const char* name, Rect damage)
+{
+  NullBackend backend{};
+  backend.async = true;
+  BusScheduler<2> bus;
+  BenchPresent first(backend, bench_config());
+  BenchPresent second(backend, bench_config());
+  (void)first.AttachBus(bus);
+  (void)second.AttachBus(bus);
+  std::size_t bytes = 0;
+  const auto FRAME = [&]()
+  {
+    bytes = 0;
+    for (BenchPresent* presenter : {&first, &second})
+    {
+      (void)presenter->BeginFrame();
+      presenter->GetSurface().FillRect(damage, Color::WHITE, RasterOp::XOR);
+      (void)presenter->EndFrame();
+      (void)presenter->QueueFrame(PresentMode::DIRTY);
+    }
+    while (bus.IsBusy())
+    {
+      const BusSlot OWNER = bus.Owner();
+      (void)bus.OnTransferDone();
+      bytes += (OWNER == 0U ? first : second).GetBackend().bytes;
+    }
+  };
+
+  for (int i = 0; i < 3; ++i)
+  {
+    FRAME();
+  }
+  run(name, bytes, [&](uint32_t) { FRAME(); });
+}
+
+// A white screen with a gray band, and a small area changing level once per cycle of
+// phases.
+void bench_gray_case(const char* name, Rect damage)
+{
+  NullBackend backend{};
+  backend.async = true;
+  BenchPresent presenter(backend, bench_config());
+  static GraySurface<FRAME_BYTES> gray;
+  (void)presenter.AttachGray(&gray);
+  gray.FillRect(Rect{0, 0, WIDTH, HEIGHT}, 3);
+  gray.FillRect(Rect{0, 40, WIDTH, 24}, 2);
+  std::size_t bytes = 0;
+  const auto CYCLE = [&](uint32_t i)
+  {
+    bytes = 0;
+    gray.FillRect(damage, static_cast<uint8_t>(i & 3U));
+    for (uint8_t phase = 0; phase < GraySurfaceBase::PHASES; ++phase)
+    {
+      presenter.GetBackend().bytes = 0;
+      (void)presenter.PresentGrayPhase();
+      (void)presenter.OnTransferDone();
+      bytes += presenter.GetBackend().bytes;
+    }
+  };
+
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    CYCLE(i);
+  }
+  run(name, bytes, CYCLE);
+}
+
+void bench_present()
+{
+  const Rect SMALL{40, 8, 24, 10};
+  bench_present_case("present/sync_full", false, PresentMode::FULL, SMALL);
+  bench_present_case("present/sync_dirty_24x10", false, PresentMode::DIRTY, SMALL);
+  bench_present_case("present/sync_diff_24x10", false, PresentMode::DIFF, SMALL);
+  bench_present_case("present/async_full", true, PresentMode::FULL, SMALL);
+  bench_present_case("present/async_dirty_24x10", true, PresentMode::DIRTY, SMALL);
+  bench_present_case("present/async_diff_24x10", true, PresentMode::DIFF, SMALL);
+  bench_scroll_case("present/scroll_line_sw", false);
+  bench_scroll_case("present/scroll_line_hw", true);
+  bench_bus_case("present/bus_two_dirty_24x10", SMALL);
+  bench_chunk_case("present/sync_full_chunk_256", false, 256);
+  bench_chunk_case("present/async_full_chunk_256", true, 256);
+  bench_slow_panel_case<2>("present/slow_panel_double_24x10", SMALL);
+  bench_slow_panel_case<3>("present/slow_panel_triple_24x10", SMALL);
+  bench_gray_case("present/gray_cycle_24x10", SMALL);
+}
+
+// Host-side simulation: the mock's RGB expansion, headless capture and golden compare.
+void bench_mock()
+{
+  static uint8_t bits[FRAME_BYTES];
+  Surface surface{};
+  surface.Bind(bits, Size{WIDTH, HEIGHT});
+  for (int16_t x = 0; x < static_cast<int16_t>(WIDTH); x += 6)
+  {
+    surface.DrawLine(Point{x, 0}, Point{static_cast<int16_t>(WIDTH - 1 - x), 63});
+  }
+  const Rect FULL{0, 0, WIDTH, HEIGHT};
+  const FrameView FRAME{bits, WIDTH, HEIGHT, WIDTH / 8U, FULL, 0, HEIGHT, &FULL, 1,
+                        nullptr, 0, PixelLayout::ROW_MAJOR_MSB};
+  static uint32_t rgb[static_cast<std::size_t>(WIDTH) * HEIGHT];
+  run("mock/expand_rgb_full", FRAME_BYTES,
+      [&](uint32_t)
+      {
+        DesktopMock::expand_to_rgb(FRAME, WIDTH / 8U, FULL, rgb);
+        g_sink = static_cast<uint8_t>(g_sink + rgb[WIDTH + 1]);
+      });
+
+  Present<DesktopMock::HeadlessBackend, FRAME_BYTES> presenter(
+      DesktopMock::HeadlessBackend{}, bench_config());
+  presenter.GetSurface().FillRect(Rect{10, 10, 100, 30});
+  (void)presenter.PresentFrame(PresentMode::FULL);
+  run("mock/headless_dirty_24x10", rect_bytes(Rect{40, 8, 24, 10}),
+      [&](uint32_t)
+      {
+        presenter.GetSurface().FillRect(Rect{40, 8, 24, 10}, Color::WHITE,
+                                        RasterOp::XOR);
+        (void)presenter.PresentFrame(PresentMode::DIRTY);
+      });
+
+  static uint8_t golden[FRAME_BYTES];
+  std::memcpy(golden, presenter.GetBackend().Capture(), FRAME_BYTES);
+  golden[FRAME_BYTES / 2U] ^= 0x10U;
+  run("mock/golden_compare", FRAME_BYTES,
+      [&](uint32_t)
+      {
+        g_sink = static_cast<uint8_t>(
+            g_sink + DesktopMock::count_diff_pixels(presenter.GetBackend().Capture(),
+                                                    golden, Size{WIDTH, HEIGHT}));
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+  {
+    g_filter = argv[1];
+  }
+  bench_surface();
+  bench_present();
+  bench_mock();
+  return 0;
+}
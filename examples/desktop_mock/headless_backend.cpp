@@ -0,0 +1,355 @@
+#include "headless_backend.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "mock_pixels.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+namespace DesktopMock
+{
+
+namespace
+{
+
+std::size_t capture_stride(uint16_t width) noexcept
+{
+  return (static_cast<std::size_t>(width) + 7U) / 8U;
+}
+
+// Last byte of a capture row with its padding bits cleared.
+uint8_t last_byte_mask(uint16_t width) noexcept
+{
+  const uint32_t USED = ((width & 7U) == 0U) ? 8U : (width & 7U);
+  return static_cast<uint8_t>(0xFFU << (8U - USED));
+}
+
+uint32_t popcount64(uint64_t value) noexcept
+{
+  value = value - ((value >> 1U) & 0x5555555555555555ULL);
+  value = (value & 0x3333333333333333ULL) + ((value >> 2U) & 0x3333333333333333ULL);
+  value = (value + (value >> 4U)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<uint32_t>((value * 0x0101010101010101ULL) >> 56U);
+}
+
+// Bits that differ between bytes [0, count) of a and b, a word at a time.
+uint32_t count_diff_bits(const uint8_t* a, const uint8_t* b, std::size_t count) noexcept
+{
+  uint32_t bits = 0;
+  std::size_t index = 0;
+  for (; index + 8U <= count; index += 8U)
+  {
+    uint64_t word_a = 0;
+    uint64_t word_b = 0;
+    std::memcpy(&word_a, a + index, sizeof(word_a));
+    std::memcpy(&word_b, b + index, sizeof(word_b));
+    bits += popcount64(word_a ^ word_b);
+  }
+  for (; index < count; ++index)
+  {
+    bits += popcount64(static_cast<uint8_t>(a[index] ^ b[index]));
+  }
+  return bits;
+}
+
+uint32_t window_bytes(Rect window, PixelLayout layout) noexcept
+{
+  if (rect_empty(window))
+  {
+    return 0;
+  }
+  const ByteWindow BYTES = layout_byte_window(window, layout);
+  return static_cast<uint32_t>(BYTES.byte_end - BYTES.byte_begin) *
+         static_cast<uint32_t>(BYTES.line_end - BYTES.line_begin);
+}
+
+// Skips whitespace and '#' comments, then reads a decimal number.
+bool read_pbm_number(std::FILE* file, uint32_t& value) noexcept
+{
+  int c = std::fgetc(file);
+  while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+  {
+    if (c == '#')
+    {
+      while (c != '\n' && c != EOF)
+      {
+        c = std::fgetc(file);
+      }
+    }
+    c = std::fgetc(file);
+  }
+  if (c < '0' || c > '9')
+  {
+    return false;
+  }
+  value = 0;
+  while (c >= '0' && c <= '9')
+  {
+    value = value * 10U + static_cast<uint32_t>(c - '0');
+    if (value > 0xFFFFU)
+    {
+      return false;
+    }
+    c = std::fgetc(file);
+  }
+  // One whitespace character ends the number; after the height the raster follows.
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+}  // namespace
+
+HeadlessBackend::HeadlessBackend(HeadlessOptions options) noexcept : options_(options) {}
+
+LibXR::ErrorCode HeadlessBackend::Init(const DisplayConfig& config) noexcept
+{
+  if (config.width == 0 || config.height == 0)
+  {
+    return LibXR::ErrorCode::ARG_ERR;
+  }
+  config_ = config;
+  capture_.assign(capture_stride(config.width) * config.height, 0U);
+  running_ = false;
+  presents_ = 0;
+  bytes_sent_ = 0;
+  return LibXR::ErrorCode::OK;
+}
+
+BackendCaps HeadlessBackend::Caps() const noexcept
+{
+  BackendCaps caps{
+      true,
+      false,
+      false,
+      options_.async,
+      std::max<uint8_t>(std::min(options_.max_dirty_rects, DirtyRegion::MAX_RECTS), 1U),
+  };
+  caps.max_chunk_bytes = options_.max_chunk_bytes;
+  return caps;
+}
+
+LibXR::ErrorCode HeadlessBackend::Present(const FrameView& frame,
+                                          PresentMode mode) noexcept
+{
+  if (capture_.empty())
+  {
+    return LibXR::ErrorCode::INIT_ERR;
+  }
+  if (running_)
+  {
+    return LibXR::ErrorCode::BUSY;
+  }
+  if (frame.bits == nullptr || frame.width == 0 || frame.height == 0)
+  {
+    return LibXR::ErrorCode::ARG_ERR;
+  }
+  if (frame.width != config_.width || frame.height != config_.height)
+  {
+    return LibXR::ErrorCode::SIZE_ERR;
+  }
+
+  const uint16_t MIN_STRIDE = layout_default_stride(frame.width, frame.layout);
+  const uint16_t STRIDE = (frame.stride_bytes == 0) ? MIN_STRIDE : frame.stride_bytes;
+  if (STRIDE < MIN_STRIDE)
+  {
+    return LibXR::ErrorCode::SIZE_ERR;
+  }
+
+  const uint16_t ROW_COUNT = (frame.row_count == 0) ? frame.height : frame.row_count;
+  if (static_cast<uint32_t>(frame.row_begin) + ROW_COUNT > frame.height)
+  {
+    return LibXR::ErrorCode::SIZE_ERR;
+  }
+
+  // Only rows backed by frame.bits can be captured; Page mode sends one band at a time.
+  const Rect STORED{0, static_cast<int16_t>(frame.row_begin), frame.width, ROW_COUNT};
+  window_count_ = 0;
+  if (mode == PresentMode::FULL || frame.dirty_rects == nullptr)
+  {
+    windows_[0] =
+        (mode == PresentMode::FULL) ? STORED : intersect_rect(frame.dirty, STORED);
+    window_count_ = 1;
+  }
+  else
+  {
+    const uint8_t COUNT = std::min<uint8_t>(frame.dirty_count, DirtyRegion::MAX_RECTS);
+    for (uint8_t i = 0; i < COUNT; ++i)
+    {
+      windows_[window_count_++] = intersect_rect(frame.dirty_rects[i], STORED);
+    }
+  }
+  for (uint8_t i = 0; i < window_count_; ++i)
+  {
+    bytes_sent_ += window_bytes(windows_[i], frame.layout);
+  }
+
+  view_ = frame;
+  stride_ = STRIDE;
+  ++presents_;
+  if (!options_.async)
+  {
+    Apply();
+    return LibXR::ErrorCode::OK;
+  }
+  running_ = true;
+  if (transfer_done_callback_ != nullptr)
+  {
+    // The callback may start the next transfer from here, so this one ends first.
+    (void)CompleteTransfer();
+    transfer_done_callback_(transfer_done_context_);
+  }
+  return LibXR::ErrorCode::OK;
+}
+
+LibXR::ErrorCode HeadlessBackend::SetPowerSave(bool enable) noexcept
+{
+  UNUSED(enable);
+  return LibXR::ErrorCode::NOT_SUPPORT;
+}
+
+LibXR::ErrorCode HeadlessBackend::SetContrast(uint8_t value) noexcept
+{
+  UNUSED(value);
+  return LibXR::ErrorCode::NOT_SUPPORT;
+}
+
+LibXR::ErrorCode HeadlessBackend::Scroll(int16_t rows) noexcept
+{
+  UNUSED(rows);
+  return LibXR::ErrorCode::NOT_SUPPORT;
+}
+
+bool HeadlessBackend::CompleteTransfer() noexcept
+{
+  if (!running_)
+  {
+    return false;
+  }
+  Apply();
+  running_ = false;
+  return true;
+}
+
+LibXR::ErrorCode HeadlessBackend::WritePbm(const std::string& path) const
+{
+  if (capture_.empty())
+  {
+    return LibXR::ErrorCode::INIT_ERR;
+  }
+  return write_pbm(path, capture_.data(), GetSize());
+}
+
+void HeadlessBackend::Apply() noexcept
+{
+  for (uint8_t i = 0; i < window_count_; ++i)
+  {
+    pack_to_msb_rows(view_, stride_, windows_[i], capture_.data());
+  }
+}
+
+uint32_t count_diff_pixels(const uint8_t* a, const uint8_t* b, Size size) noexcept
+{
+  if (size.w == 0)
+  {
+    return 0;
+  }
+  const std::size_t STRIDE = capture_stride(size.w);
+  if ((size.w & 7U) == 0U)
+  {
+    // No padding: the rows form one run.
+    return count_diff_bits(a, b, STRIDE * size.h);
+  }
+  const uint8_t LAST_MASK = last_byte_mask(size.w);
+  uint32_t count = 0;
+  for (uint16_t y = 0; y < size.h; ++y)
+  {
+    const std::size_t ROW = static_cast<std::size_t>(y) * STRIDE;
+    count += count_diff_bits(a + ROW, b + ROW, STRIDE - 1U);
+    count += popcount64(
+        static_cast<uint8_t>((a[ROW + STRIDE - 1U] ^ b[ROW + STRIDE - 1U]) & LAST_MASK));
+  }
+  return count;
+}
+
+LibXR::ErrorCode write_pbm(const std::string& path, const uint8_t* bits, Size size)
+{
+  if (bits == nullptr || size.w == 0 || size.h == 0)
+  {
+    return LibXR::ErrorCode::ARG_ERR;
+  }
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    return LibXR::ErrorCode::FAILED;
+  }
+
+  const std::size_t STRIDE = capture_stride(size.w);
+  const uint8_t LAST_MASK = last_byte_mask(size.w);
+  std::vector<uint8_t> row(STRIDE);
+  bool ok = std::fprintf(file, "P4\n%u %u\n", static_cast<unsigned>(size.w),
+                         static_cast<unsigned>(size.h)) > 0;
+  for (uint16_t y = 0; ok && y < size.h; ++y)
+  {
+    const uint8_t* source = bits + static_cast<std::size_t>(y) * STRIDE;
+    for (std::size_t i = 0; i < STRIDE; ++i)
+    {
+      row[i] = static_cast<uint8_t>(~source[i]);
+    }
+    row[STRIDE - 1U] = static_cast<uint8_t>(row[STRIDE - 1U] & LAST_MASK);
+    ok = std::fwrite(row.data(), 1, STRIDE, file) == STRIDE;
+  }
+  ok = (std::fclose(file) == 0) && ok;
+  return ok ? LibXR::ErrorCode::OK : LibXR::ErrorCode::FAILED;
+}
+
+LibXR::ErrorCode read_pbm(const std::string& path, Size size, std::vector<uint8_t>& bits)
+{
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+  {
+    return LibXR::ErrorCode::NOT_FOUND;
+  }
+
+  uint32_t width = 0;
+  uint32_t height = 0;
+  const bool HEADER = std::fgetc(file) == 'P' && std::fgetc(file) == '4' &&
+                      read_pbm_number(file, width) && read_pbm_number(file, height);
+  if (!HEADER)
+  {
+    std::fclose(file);
+    return LibXR::ErrorCode::CHECK_ERR;
+  }
+  if (width != size.w || height != size.h)
+  {
+    std::fclose(file);
+    return LibXR::ErrorCode::SIZE_ERR;
+  }
+
+  const std::size_t STRIDE = capture_stride(size.w);
+  const uint8_t LAST_MASK = last_byte_mask(size.w);
+  bits.assign(STRIDE * size.h, 0U);
+  const bool COMPLETE = std::fread(bits.data(), 1, bits.size(), file) == bits.size();
+  std::fclose(file);
+  if (!COMPLETE)
+  {
+    return LibXR::ErrorCode::CHECK_ERR;
+  }
+  for (std::size_t i = 0; i < bits.size(); ++i)
+  {
+    bits[i] = static_cast<uint8_t>(~bits[i]);
+  }
+  for (uint16_t y = 0; y < size.h; ++y)
+  {
+    uint8_t& last = bits[static_cast<std::size_t>(y) * STRIDE + STRIDE - 1U];
+    last = static_cast<uint8_t>(last & LAST_MASK);
+  }
+  return LibXR::ErrorCode::OK;
+}
+
+}  // namespace DesktopMock
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "libxr_def.hpp"
+#include "present_types.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+namespace DesktopMock
+{
+
+struct HeadlessOptions
+{
+  // Transfers then run until CompleteTransfer(), which the caller follows with
+  // Present::OnTransferDone(), so buffer reuse during a transfer shows in the capture.
+  bool async{false};
+  uint8_t max_dirty_rects{DirtyRegion::MAX_RECTS};
+  uint16_t max_chunk_bytes{0};
+};
+
+// Portable backend that records what the panel would show, for CI and benchmarks. The
+// capture is 1bpp (1 lit) in rows of (width + 7) / 8 bytes, leftmost pixel in bit 7,
+// whatever the frame layout: the raster of a binary PBM.
+class HeadlessBackend
+{
+ public:
+  // Runs inside an async Present() once its transfer is applied, like a HAL that
+  // completes synchronously; it usually calls Present::OnTransferDone().
+  using TransferDoneCallback = void (*)(void* context);
+
+  HeadlessBackend() = default;
+  explicit HeadlessBackend(HeadlessOptions options) noexcept;
+
+  LibXR::ErrorCode Init(const DisplayConfig& config) noexcept;
+  BackendCaps Caps() const noexcept;
+  LibXR::ErrorCode Present(const FrameView& frame, PresentMode mode) noexcept;
+  LibXR::ErrorCode SetPowerSave(bool enable) noexcept;
+  LibXR::ErrorCode SetContrast(uint8_t value) noexcept;
+  LibXR::ErrorCode Scroll(int16_t rows) noexcept;
+
+  // Applies the running async transfer to the capture. False when none was running.
+  bool CompleteTransfer() noexcept;
+  bool IsTransferRunning() const noexcept { return running_; }
+  // With a callback, async transfers complete before Present() returns and
+  // CompleteTransfer() has nothing left to do. nullptr restores deferred completion.
+  void SetTransferDoneCallback(TransferDoneCallback callback, void* context) noexcept
+  {
+    transfer_done_context_ = context;
+    transfer_done_callback_ = callback;
+  }
+
+  const uint8_t* Capture() const noexcept { return capture_.data(); }
+  Size GetSize() const noexcept { return Size{config_.width, config_.height}; }
+  uint32_t PresentCount() const noexcept { return presents_; }
+  // Framebuffer bytes of the transferred windows.
+  uint64_t BytesSent() const noexcept { return bytes_sent_; }
+
+  LibXR::ErrorCode WritePbm(const std::string& path) const;
+
+ private:
+  void Apply() noexcept;
+
+  HeadlessOptions options_{};
+  DisplayConfig config_{};
+  std::vector<uint8_t> capture_{};
+  // The running transfer; its rects are copied as FrameView only lends them.
+  FrameView view_{};
+  uint16_t stride_{0};
+  std::array<Rect, DirtyRegion::MAX_RECTS> windows_{};
+  uint8_t window_count_{0};
+  bool running_{false};
+  TransferDoneCallback transfer_done_callback_{nullptr};
+  void* transfer_done_context_{nullptr};
+  uint32_t presents_{0};
+  uint64_t bytes_sent_{0};
+};
+
+// Pixels that differ between two images in the capture format, padding bits ignored.
+uint32_t count_diff_pixels(const uint8_t* a, const uint8_t* b, Size size) noexcept;
+
+// Binary PBM (P4) in the capture format. PBM marks black with 1, so lit pixels are
+// stored as 0 and the file shows the panel as it looks. read_pbm() fails with SIZE_ERR
+// on an image of another size.
+LibXR::ErrorCode write_pbm(const std::string& path, const uint8_t* bits, Size size);
+LibXR::ErrorCode read_pbm(const std::string& path, Size size, std::vector<uint8_t>& bits);
+
+}  // namespace DesktopMock
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,181 @@
+#include "mock_pixels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+namespace LibXR
+{
+namespace MonoGL
+{
+namespace DesktopMock
+{
+
+namespace
+{
+
+// pixels[v][k] is pixel k of byte v, leftmost (k = 0) in bit 7.
+struct ExpandTable
+{
+  std::array<std::array<uint32_t, 8>, 256> pixels{};
+};
+
+constexpr ExpandTable make_expand_table() noexcept
+{
+  ExpandTable table{};
+  for (uint32_t value = 0; value < 256U; ++value)
+  {
+    for (uint32_t k = 0; k < 8U; ++k)
+    {
+      table.pixels[value][k] = (((value >> (7U - k)) & 1U) != 0U) ? RGB_ON : RGB_OFF;
+    }
+  }
+  return table;
+}
+
+constexpr std::array<uint8_t, 256> make_reverse_table() noexcept
+{
+  std::array<uint8_t, 256> table{};
+  for (uint32_t value = 0; value < 256U; ++value)
+  {
+    uint32_t reversed = 0;
+    for (uint32_t bit = 0; bit < 8U; ++bit)
+    {
+      reversed |= ((value >> bit) & 1U) << (7U - bit);
+    }
+    table[value] = static_cast<uint8_t>(reversed);
+  }
+  return table;
+}
+
+constexpr ExpandTable EXPAND = make_expand_table();
+constexpr std::array<uint8_t, 256> REVERSED = make_reverse_table();
+
+// Byte of frame line with the leftmost (or, for VERTICAL_PAGE, top) pixel in bit 7.
+uint8_t msb_byte(PixelLayout layout, uint8_t value) noexcept
+{
+  return (layout == PixelLayout::ROW_MAJOR_MSB) ? value : REVERSED[value];
+}
+
+const uint8_t* frame_line(const FrameView& frame, uint16_t stride, int32_t line) noexcept
+{
+  const int32_t FIRST = (frame.layout == PixelLayout::VERTICAL_PAGE)
+                            ? frame.row_begin / 8
+                            : static_cast<int32_t>(frame.row_begin);
+  return frame.bits + static_cast<std::size_t>(line - FIRST) * stride;
+}
+
+// Bits of byte index covering pixels [begin, end), MSB-first.
+uint8_t span_mask(int32_t index, int32_t begin, int32_t end) noexcept
+{
+  const int32_t FIRST = std::max<int32_t>(begin - index * 8, 0);
+  const int32_t LAST = std::min<int32_t>(end - index * 8, 8);
+  return static_cast<uint8_t>((0xFFU >> FIRST) & (0xFFU << (8 - LAST)));
+}
+
+}  // namespace
+
+void expand_to_rgb(const FrameView& frame, uint16_t stride, Rect region,
+                   uint32_t* rgb) noexcept
+{
+  if (rect_empty(region))
+  {
+    return;
+  }
+  const int32_t X_END = static_cast<int32_t>(region.x) + region.w;
+  const int32_t Y_END = static_cast<int32_t>(region.y) + region.h;
+
+  if (frame.layout == PixelLayout::VERTICAL_PAGE)
+  {
+    // A byte is 8 rows of one column, top pixel in bit 0.
+    for (int32_t page = region.y / 8; page <= (Y_END - 1) / 8; ++page)
+    {
+      const uint8_t* line = frame_line(frame, stride, page);
+      const int32_t ROW_BEGIN = std::max<int32_t>(region.y, page * 8);
+      const int32_t ROW_END = std::min<int32_t>(Y_END, page * 8 + 8);
+      for (int32_t x = region.x; x < X_END; ++x)
+      {
+        const auto& column = EXPAND.pixels[msb_byte(frame.layout, line[x])];
+        for (int32_t y = ROW_BEGIN; y < ROW_END; ++y)
+        {
+          rgb[static_cast<std::size_t>(y) * frame.width + static_cast<std::size_t>(x)] =
+              column[y - page * 8];
+        }
+      }
+    }
+    return;
+  }
+
+  for (int32_t y = region.y; y < Y_END; ++y)
+  {
+    const uint8_t* line = frame_line(frame, stride, y);
+    uint32_t* out = rgb + static_cast<std::size_t>(y) * frame.width;
+    const int32_t FIRST = region.x / 8;
+    const int32_t LAST = (X_END - 1) / 8;
+    for (int32_t index = FIRST; index <= LAST; ++index)
+    {
+      const auto& pixels = EXPAND.pixels[msb_byte(frame.layout, line[index])];
+      // Inner bytes are whole.
+      if (index != FIRST && index != LAST)
+      {
+        std::memcpy(out + index * 8, pixels.data(), sizeof(pixels));
+        continue;
+      }
+      const int32_t BEGIN = std::max<int32_t>(region.x, index * 8);
+      const int32_t END = std::min<int32_t>(X_END, index * 8 + 8);
+      std::copy_n(pixels.begin() + (BEGIN - index * 8), END - BEGIN, out + BEGIN);
+    }
+  }
+}
+
+void pack_to_msb_rows(const FrameView& frame, uint16_t stride, Rect region,
+                      uint8_t* bits) noexcept
+{
+  if (rect_empty(region))
+  {
+    return;
+  }
+  const std::size_t DST_STRIDE = (static_cast<std::size_t>(frame.width) + 7U) / 8U;
+  const int32_t X_END = static_cast<int32_t>(region.x) + region.w;
+  const int32_t Y_END = static_cast<int32_t>(region.y) + region.h;
+
+  if (frame.layout == PixelLayout::VERTICAL_PAGE)
+  {
+    for (int32_t y = region.y; y < Y_END; ++y)
+    {
+      const uint8_t* line = frame_line(frame, stride, y / 8);
+      uint8_t* out = bits + static_cast<std::size_t>(y) * DST_STRIDE;
+      const uint8_t ROW_BIT = static_cast<uint8_t>(1U << (y & 7));
+      for (int32_t x = region.x; x < X_END; ++x)
+      {
+        const uint8_t PIXEL = static_cast<uint8_t>(0x80U >> (x & 7));
+        if ((line[x] & ROW_BIT) != 0U)
+        {
+          out[x / 8] = static_cast<uint8_t>(out[x / 8] | PIXEL);
+        }
+        else
+        {
+          out[x / 8] = static_cast<uint8_t>(out[x / 8] & ~PIXEL);
+        }
+      }
+    }
+    return;
+  }
+
+  for (int32_t y = region.y; y < Y_END; ++y)
+  {
+    const uint8_t* line = frame_line(frame, stride, y);
+    uint8_t* out = bits + static_cast<std::size_t>(y) * DST_STRIDE;
+    for (int32_t index = region.x / 8; index <= (X_END - 1) / 8; ++index)
+    {
+      const uint8_t MASK = span_mask(index, region.x, X_END);
+      const uint8_t VALUE = msb_byte(frame.layout, line[index]);
+      out[index] = static_cast<uint8_t>((out[index] & ~MASK) | (VALUE & MASK));
+    }
+  }
+}
+
+}  // namespace DesktopMock
+}  // namespace MonoGL
+}  // namespace LibXR
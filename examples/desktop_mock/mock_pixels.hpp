@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include "present_types.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+namespace DesktopMock
+{
+
+// 0x00RRGGBB of lit and dark pixels in the mock windows.
+constexpr uint32_t RGB_ON = 0x00FFFFFFU;
+constexpr uint32_t RGB_OFF = 0x00000000U;
+
+// Writes the pixels of region to rgb, a frame.width wide image of the whole panel.
+// region must lie within the rows frame holds; stride is the checked line stride. Whole
+// bytes expand through a lookup table, 8 pixels at a time.
+void expand_to_rgb(const FrameView& frame, uint16_t stride, Rect region,
+                   uint32_t* rgb) noexcept;
+
+// The same region packed as the capture of HeadlessBackend: rows of (width + 7) / 8
+// bytes, leftmost pixel in bit 7. Padding bits are left clear.
+void pack_to_msb_rows(const FrameView& frame, uint16_t stride, Rect region,
+                      uint8_t* bits) noexcept;
+
+}  // namespace DesktopMock
+}  // namespace MonoGL
+}  // namespace LibXR
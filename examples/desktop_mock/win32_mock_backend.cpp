@@ -13,6 +13,8 @@
 #endif
 #include <windows.h>
 
+#include "mock_pixels.hpp"
+
 namespace LibXR
 {
 namespace MonoGL
@@ -205,7 +207,7 @@ LibXR::ErrorCode Win32MockBackend::Init(const DisplayConfig& config) noexcept
 
   const std::size_t PIXEL_COUNT =
       static_cast<std::size_t>(config.width) * static_cast<std::size_t>(config.height);
-  state_->rgba_buffer.assign(PIXEL_COUNT, 0x00000000U);
+  state_->rgba_buffer.assign(PIXEL_COUNT, RGB_OFF);
 
   ShowWindow(state_->hwnd, SW_SHOWDEFAULT);
   UpdateWindow(state_->hwnd);
@@ -215,16 +217,16 @@ LibXR::ErrorCode Win32MockBackend::Init(const DisplayConfig& config) noexcept
 BackendCaps Win32MockBackend::Caps() const noexcept
 {
   return BackendCaps{
+      true,
       false,
       false,
       false,
-      false,
+      DirtyRegion::MAX_RECTS,
   };
 }
 
 LibXR::ErrorCode Win32MockBackend::Present(const FrameView& frame, PresentMode mode) noexcept
 {
-  UNUSED(mode);
   if (state_ == nullptr || state_->hwnd == nullptr)
   {
     return LibXR::ErrorCode::INIT_ERR;
@@ -238,30 +240,39 @@ LibXR::ErrorCode Win32MockBackend::Present(const FrameView& frame, PresentMode m
     return LibXR::ErrorCode::SIZE_ERR;
   }
 
-  const uint16_t MIN_STRIDE = static_cast<uint16_t>((frame.width + 7U) / 8U);
+  const uint16_t MIN_STRIDE = layout_default_stride(frame.width, frame.layout);
   const uint16_t STRIDE = (frame.stride_bytes == 0) ? MIN_STRIDE : frame.stride_bytes;
   if (STRIDE < MIN_STRIDE)
   {
     return LibXR::ErrorCode::SIZE_ERR;
   }
 
+  const uint16_t ROW_COUNT = (frame.row_count == 0) ? frame.height : frame.row_count;
+  if (static_cast<uint32_t>(frame.row_begin) + ROW_COUNT > frame.height)
+  {
+    return LibXR::ErrorCode::SIZE_ERR;
+  }
+
   const std::size_t PIXEL_COUNT =
       static_cast<std::size_t>(frame.width) * static_cast<std::size_t>(frame.height);
   if (state_->rgba_buffer.size() != PIXEL_COUNT)
   {
-    state_->rgba_buffer.assign(PIXEL_COUNT, 0x00000000U);
+    state_->rgba_buffer.assign(PIXEL_COUNT, RGB_OFF);
   }
 
-  for (uint16_t y = 0; y < frame.height; ++y)
+  // Only rows backed by frame.bits can be converted; Page mode sends one band at a time.
+  const Rect STORED{0, static_cast<int16_t>(frame.row_begin), frame.width, ROW_COUNT};
+  if (mode == PresentMode::FULL || frame.dirty_rects == nullptr)
   {
-    const uint8_t* row = frame.bits + static_cast<std::size_t>(y) * STRIDE;
-    for (uint16_t x = 0; x < frame.width; ++x)
+    const Rect REGION = (mode == PresentMode::FULL) ? STORED : intersect_rect(frame.dirty, STORED);
+    expand_to_rgb(frame, STRIDE, REGION, state_->rgba_buffer.data());
+  }
+  else
+  {
+    for (uint8_t i = 0; i < frame.dirty_count; ++i)
     {
-      const uint8_t BYTE = row[x / 8U];
-      const uint8_t BIT_MASK = static_cast<uint8_t>(0x80U >> (x & 0x7U));
-      const bool PIXEL_ON = (BYTE & BIT_MASK) != 0U;
-      state_->rgba_buffer[static_cast<std::size_t>(y) * frame.width + x] =
-          PIXEL_ON ? 0x00FFFFFFU : 0x00000000U;
+      expand_to_rgb(frame, STRIDE, intersect_rect(frame.dirty_rects[i], STORED),
+                    state_->rgba_buffer.data());
     }
   }
 
@@ -282,6 +293,12 @@ LibXR::ErrorCode Win32MockBackend::SetContrast(uint8_t value) noexcept
   return LibXR::ErrorCode::NOT_SUPPORT;
 }
 
+LibXR::ErrorCode Win32MockBackend::Scroll(int16_t rows) noexcept
+{
+  UNUSED(rows);
+  return LibXR::ErrorCode::NOT_SUPPORT;
+}
+
 }  // namespace DesktopMock
 }  // namespace MonoGL
 }  // namespace LibXR
@@ -27,6 +27,7 @@ class Win32MockBackend
   LibXR::ErrorCode Present(const FrameView& frame, PresentMode mode) noexcept;
   LibXR::ErrorCode SetPowerSave(bool enable) noexcept;
   LibXR::ErrorCode SetContrast(uint8_t value) noexcept;
+  LibXR::ErrorCode Scroll(int16_t rows) noexcept;
 
  private:
   static constexpr const wchar_t* WINDOW_CLASS_NAME = L"MonoGLXRDesktopMockWindow";
@@ -0,0 +1,278 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fonts/u8g2_font_6x10_ascii.hpp"
+#include "headless_backend.hpp"
+#include "present.hpp"
+
+// Renders each scene through Present and HeadlessBackend and compares the capture with
+// <golden_dir>/<scene>.pbm:
+//   monoglxr_golden <golden_dir> [--update]
+// Every scene is rendered in each pixel layout, synchronously and with async transfers,
+// whole or in chunks that complete later or inside Present(), and all variants must
+// capture the same image. --update writes the goldens instead of
+// comparing. A capture that differs is written to <scene>.actual.pbm in the working
+// directory, not next to the goldens. Exits non-zero when anything differs.
+
+namespace
+{
+
+using namespace LibXR::MonoGL;
+using namespace LibXR::MonoGL::DesktopMock;
+
+constexpr uint16_t WIDTH = 128U;
+constexpr uint16_t HEIGHT = 64U;
+constexpr std::size_t FRAME_BYTES = static_cast<std::size_t>(WIDTH / 8U) * HEIGHT;
+
+using GoldenPresent = Present<HeadlessBackend, FRAME_BYTES>;
+
+struct Variant
+{
+  bool async;
+  uint16_t max_chunk_bytes;
+  bool complete_inline;  // The backend completes each transfer inside Present().
+};
+
+constexpr std::array<Variant, 4> VARIANTS{{
+    {false, 0, false},
+    {true, 0, false},
+    {true, 96, false},
+    {true, 96, true},
+}};
+
+struct Scene
+{
+  const char* name;
+  Rotation rotation;
+  uint32_t frames;  // Presents; frame 0 is FULL, the rest DIRTY.
+  void (*draw)(Surface& surface, uint32_t frame);
+};
+
+TextStyle text_style() noexcept
+{
+  TextStyle style{};
+  style.font = &U8G2_FONT_6X10_ASCII;
+  return style;
+}
+
+void draw_text(Surface& surface, uint32_t)
+{
+  surface.Clear(Color::BLACK);
+  const TextStyle STYLE = text_style();
+  surface.DrawTextTopLeft(Point{4, 4}, "hello world", STYLE);
+  surface.DrawTextTopLeft(Point{4, 20}, "MonoGLXR 0123456789", STYLE);
+  surface.FillRect(Rect{0, 40, WIDTH, 12}, Color::WHITE);
+  surface.DrawTextTopLeft(Point{4, 41}, "inverted line", STYLE, RasterOp::XOR);
+}
+
+void draw_shapes(Surface& surface, uint32_t)
+{
+  surface.Clear(Color::BLACK);
+  surface.DrawRect(Rect{2, 2, 40, 24});
+  surface.FillRoundRect(Rect{48, 2, 36, 24}, 6);
+  surface.DrawCircle(Point{106, 14}, 12);
+  surface.FillCircle(Point{20, 46}, 14);
+  surface.DrawEllipse(Point{64, 46}, 24, 10);
+  surface.DrawLine(Point{0, 63}, Point{127, 30}, Color::WHITE, RasterOp::XOR);
+  surface.FillRect(Rect{90, 34, 34, 26}, Color::WHITE, RasterOp::XOR);
+}
+
+const uint8_t* ramp_row(void* context, uint16_t)
+{
+  return static_cast<const uint8_t*>(context);
+}
+
+void draw_gray(Surface& surface, uint32_t)
+{
+  static std::array<uint8_t, WIDTH> ramp{};
+  static std::array<int16_t, WIDTH + 1U> errors{};
+  for (uint16_t x = 0; x < WIDTH; ++x)
+  {
+    ramp[x] = static_cast<uint8_t>(x * 255U / (WIDTH - 1U));
+  }
+  GrayStyle style{};
+  style.dither = DitherMode::THRESHOLD;
+  surface.DrawGray8(Point{0, 0}, Size{WIDTH, 20}, ramp_row, ramp.data(), style);
+  style.dither = DitherMode::ORDERED;
+  surface.DrawGray8(Point{0, 22}, Size{WIDTH, 20}, ramp_row, ramp.data(), style);
+  style.dither = DitherMode::FLOYD_STEINBERG;
+  style.errors = errors.data();
+  style.error_count = static_cast<uint16_t>(errors.size());
+  surface.DrawGray8(Point{0, 44}, Size{WIDTH, 20}, ramp_row, ramp.data(), style);
+}
+
+// Incremental frames: a counter and a moving bar, presented as dirty updates.
+void draw_counter(Surface& surface, uint32_t frame)
+{
+  if (frame == 0)
+  {
+    surface.Clear(Color::BLACK);
+    surface.DrawRect(Rect{0, 0, WIDTH, HEIGHT});
+  }
+  char text[16];
+  std::snprintf(text, sizeof(text), "frame %02u", static_cast<unsigned>(frame));
+  surface.FillRect(Rect{8, 8, 60, 12}, Color::BLACK);
+  surface.DrawTextTopLeft(Point{8, 9}, text, text_style());
+  surface.FillRect(Rect{static_cast<int16_t>(4 + frame * 9), 40, 8, 16}, Color::WHITE,
+                   RasterOp::XOR);
+}
+
+void draw_rotated(Surface& surface, uint32_t)
+{
+  surface.Clear(Color::BLACK);
+  surface.DrawTextTopLeft(Point{2, 2}, "R90", text_style());
+  surface.DrawRect(Rect{0, 0, 64, 128});
+  surface.FillCircle(Point{32, 90}, 20);
+}
+
+constexpr std::array<Scene, 5> SCENES{{
+    {"text", Rotation::R0, 1, draw_text},
+    {"shapes", Rotation::R0, 1, draw_shapes},
+    {"gray", Rotation::R0, 1, draw_gray},
+    {"counter", Rotation::R0, 12, draw_counter},
+    {"rotated", Rotation::R90, 1, draw_rotated},
+}};
+
+void finish_transfer(void* context)
+{
+  (void)static_cast<GoldenPresent*>(context)->OnTransferDone();
+}
+
+// Renders scene into capture; false when a present failed.
+bool render(const Scene& scene, PixelLayout layout, const Variant& variant,
+            std::vector<uint8_t>& capture)
+{
+  DisplayConfig config{};
+  config.width = WIDTH;
+  config.height = HEIGHT;
+  config.rotation = scene.rotation;
+  config.layout = layout;
+  HeadlessOptions options{};
+  options.async = variant.async;
+  options.max_chunk_bytes = variant.max_chunk_bytes;
+  GoldenPresent presenter(HeadlessBackend(options), config);
+  if (variant.complete_inline)
+  {
+    presenter.GetBackend().SetTransferDoneCallback(finish_transfer, &presenter);
+  }
+
+  for (uint32_t frame = 0; frame < scene.frames; ++frame)
+  {
+    scene.draw(presenter.GetSurface(), frame);
+    const LibXR::ErrorCode STATUS =
+        presenter.PresentFrame(frame == 0 ? PresentMode::FULL : PresentMode::DIRTY);
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      std::printf("%s: present failed (%d)\n", scene.name, static_cast<int>(STATUS));
+      return false;
+    }
+    while (presenter.GetBackend().CompleteTransfer())
+    {
+      (void)presenter.OnTransferDone();
+    }
+    if (presenter.IsTransferInProgress())
+    {
+      std::printf("%s: transfer left running\n", scene.name);
+      return false;
+    }
+  }
+  const HeadlessBackend& backend = presenter.GetBackend();
+  const Size SIZE = backend.GetSize();
+  const std::size_t BYTES = static_cast<std::size_t>((SIZE.w + 7U) / 8U) * SIZE.h;
+  capture.assign(backend.Capture(), backend.Capture() + BYTES);
+  return true;
+}
+
+// Renders every variant of scene and checks them against the golden image.
+bool check_scene(const Scene& scene, const std::string& golden_dir, bool update)
+{
+  constexpr std::array<PixelLayout, 3> LAYOUTS{PixelLayout::ROW_MAJOR_MSB,
+                                                PixelLayout::ROW_MAJOR_LSB,
+                                                PixelLayout::VERTICAL_PAGE};
+  const Size SIZE{WIDTH, HEIGHT};
+  std::vector<uint8_t> first{};
+  std::vector<uint8_t> capture{};
+  bool ok = true;
+  for (const PixelLayout LAYOUT : LAYOUTS)
+  {
+    for (std::size_t v = 0; v < VARIANTS.size(); ++v)
+    {
+      if (!render(scene, LAYOUT, VARIANTS[v], capture))
+      {
+        return false;
+      }
+      if (first.empty())
+      {
+        first = capture;
+        continue;
+      }
+      const uint32_t DIFF = count_diff_pixels(first.data(), capture.data(), SIZE);
+      if (DIFF != 0U)
+      {
+        std::printf("%s: layout %d variant %u differs from the first in %u pixels\n",
+                    scene.name, static_cast<int>(LAYOUT), static_cast<unsigned>(v),
+                    static_cast<unsigned>(DIFF));
+        ok = false;
+      }
+    }
+  }
+
+  const std::string PATH = golden_dir + "/" + scene.name + ".pbm";
+  if (update)
+  {
+    if (write_pbm(PATH, first.data(), SIZE) != LibXR::ErrorCode::OK)
+    {
+      std::printf("%s: cannot write %s\n", scene.name, PATH.c_str());
+      return false;
+    }
+    std::printf("%s: wrote %s\n", scene.name, PATH.c_str());
+    return ok;
+  }
+
+  std::vector<uint8_t> golden{};
+  const LibXR::ErrorCode STATUS = read_pbm(PATH, SIZE, golden);
+  if (STATUS != LibXR::ErrorCode::OK)
+  {
+    std::printf("%s: cannot read %s (%d)\n", scene.name, PATH.c_str(),
+                static_cast<int>(STATUS));
+    return false;
+  }
+  const uint32_t DIFF = count_diff_pixels(golden.data(), first.data(), SIZE);
+  if (DIFF != 0U)
+  {
+    const std::string ACTUAL = std::string(scene.name) + ".actual.pbm";
+    (void)write_pbm(ACTUAL, first.data(), SIZE);
+    std::printf("%s: %u pixels differ from the golden image, see %s\n", scene.name,
+                static_cast<unsigned>(DIFF), ACTUAL.c_str());
+    return false;
+  }
+  if (ok)
+  {
+    std::printf("%s: ok\n", scene.name);
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::printf("usage: %s <golden_dir> [--update]\n", argv[0]);
+    return 2;
+  }
+  const std::string GOLDEN_DIR = argv[1];
+  const bool UPDATE = argc > 2 && std::strcmp(argv[2], "--update") == 0;
+  bool ok = true;
+  for (const Scene& scene : SCENES)
+  {
+    ok = check_scene(scene, GOLDEN_DIR, UPDATE) && ok;
+  }
+  return ok ? 0 : 1;
+}
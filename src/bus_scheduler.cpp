@@ -0,0 +1,167 @@
+#include "bus_scheduler.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+namespace
+{
+
+// a is due before b on the wrapping byte clock.
+bool finishes_before(uint32_t a, uint32_t b) noexcept
+{
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+}  // namespace
+
+void BusSchedulerBase::BindStorage(Entry* entries, uint8_t capacity) noexcept
+{
+  entries_ = entries;
+  capacity_ = capacity;
+  count_ = 0;
+}
+
+BusSlot BusSchedulerBase::Attach(const BusClient& client) noexcept
+{
+  if (entries_ == nullptr || count_ >= capacity_ || client.start == nullptr ||
+      client.done == nullptr)
+  {
+    return INVALID_BUS_SLOT;
+  }
+  Entry& entry = entries_[count_];
+  entry.client = client;
+  entry.queued.store(false, std::memory_order_relaxed);
+  return count_++;
+}
+
+void BusSchedulerBase::Request(BusSlot slot, uint32_t bytes) noexcept
+{
+  if (slot >= count_)
+  {
+    return;
+  }
+  Entry& entry = entries_[slot];
+  // A request that has not started yet keeps its tag; the client sends its newest
+  // content when it does.
+  if (!entry.queued.load(std::memory_order_acquire))
+  {
+    entry.bytes = bytes;
+    entry.finish = clock_.load(std::memory_order_relaxed) + bytes;
+    entry.queued.store(true, std::memory_order_release);
+  }
+  Kick();
+}
+
+void BusSchedulerBase::Kick() noexcept
+{
+  bool expected = false;
+  if (busy_.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+  {
+    Dispatch();
+  }
+}
+
+LibXR::ErrorCode BusSchedulerBase::OnTransferDone() noexcept
+{
+  const BusSlot OWNER = owner_.load(std::memory_order_acquire);
+  if (!busy_.load(std::memory_order_acquire) || OWNER == INVALID_BUS_SLOT)
+  {
+    return LibXR::ErrorCode::STATE_ERR;
+  }
+  const BusClient& client = entries_[OWNER].client;
+  const LibXR::ErrorCode STATUS = client.done(client.context);
+  if (STATUS == LibXR::ErrorCode::BUSY)
+  {
+    return STATUS;
+  }
+  owner_.store(INVALID_BUS_SLOT, std::memory_order_release);
+  Dispatch();
+  return STATUS;
+}
+
+bool BusSchedulerBase::IsQueued(BusSlot slot) const noexcept
+{
+  return slot < count_ && entries_[slot].queued.load(std::memory_order_acquire);
+}
+
+BusSlot BusSchedulerBase::Owner() const noexcept
+{
+  return owner_.load(std::memory_order_acquire);
+}
+
+BusSlot BusSchedulerBase::Pick(uint32_t skipped) const noexcept
+{
+  BusSlot best = INVALID_BUS_SLOT;
+  for (BusSlot slot = 0; slot < count_; ++slot)
+  {
+    const Entry& entry = entries_[slot];
+    if ((skipped & (1UL << slot)) != 0U || !entry.queued.load(std::memory_order_acquire))
+    {
+      continue;
+    }
+    if (best == INVALID_BUS_SLOT)
+    {
+      best = slot;
+      continue;
+    }
+    const Entry& current = entries_[best];
+    if (entry.client.priority < current.client.priority ||
+        (entry.client.priority == current.client.priority &&
+         finishes_before(entry.finish, current.finish)))
+    {
+      best = slot;
+    }
+  }
+  return best;
+}
+
+void BusSchedulerBase::Dispatch() noexcept
+{
+  // Clients that answered BUSY stay queued but are not retried until the next
+  // dispatch.
+  uint32_t skipped = 0;
+  while (true)
+  {
+    const BusSlot SLOT = Pick(skipped);
+    if (SLOT == INVALID_BUS_SLOT)
+    {
+      busy_.store(false, std::memory_order_release);
+      // A request may have been queued after the scan, while the bus still looked busy
+      // to it; take the bus back for it.
+      if (Pick(skipped) == INVALID_BUS_SLOT)
+      {
+        return;
+      }
+      bool expected = false;
+      if (!busy_.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+      {
+        return;
+      }
+      continue;
+    }
+
+    Entry& entry = entries_[SLOT];
+    if (!entry.queued.exchange(false, std::memory_order_acq_rel))
+    {
+      continue;
+    }
+    owner_.store(SLOT, std::memory_order_release);
+    const LibXR::ErrorCode STATUS = entry.client.start(entry.client.context);
+    if (STATUS == LibXR::ErrorCode::OK)
+    {
+      clock_.fetch_add(entry.bytes, std::memory_order_relaxed);
+      return;
+    }
+    owner_.store(INVALID_BUS_SLOT, std::memory_order_release);
+    if (STATUS == LibXR::ErrorCode::BUSY)
+    {
+      entry.queued.store(true, std::memory_order_release);
+      skipped |= 1UL << SLOT;
+    }
+  }
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
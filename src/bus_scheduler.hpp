@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "libxr_def.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+using BusSlot = uint8_t;
+constexpr BusSlot INVALID_BUS_SLOT = 0xFFU;
+
+// One display on a shared bus, normally a Present registered by Present::AttachBus().
+// start() runs the client's queued frame: OK once its transfer is running, BUSY to stay
+// queued (the client calls Kick() when it can send), anything else when it had nothing
+// to send. done() completes the running transfer, or returns BUSY when it went on with
+// another one (the next chunk of a frame), which keeps the bus.
+struct BusClient
+{
+  void* context{nullptr};
+  LibXR::ErrorCode (*start)(void* context){nullptr};
+  LibXR::ErrorCode (*done)(void* context){nullptr};
+  uint8_t priority{0};  // Lower values are served first.
+};
+
+// Serializes the frames of several displays on one bus and chains them from its
+// transfer-complete interrupt, so it stays busy while anything is queued.
+//
+// Each slot holds at most one request. A frame queued again before it started keeps
+// its place and goes out once, with the newest content. Requests run by client priority,
+// then by finish tag: bus bytes sent so far plus the request's own size, so small
+// updates overtake large ones without starving them.
+class BusSchedulerBase
+{
+ public:
+  BusSchedulerBase(const BusSchedulerBase&) = delete;
+  BusSchedulerBase& operator=(const BusSchedulerBase&) = delete;
+
+  // Returns INVALID_BUS_SLOT when every slot is taken or a callback is missing.
+  BusSlot Attach(const BusClient& client) noexcept;
+
+  // Queues a frame of about bytes for slot and starts it when the bus is idle.
+  void Request(BusSlot slot, uint32_t bytes) noexcept;
+  // Starts the best queued frame if the bus is idle.
+  void Kick() noexcept;
+  // Call this from the bus transfer-complete ISR. Completes the running transfer and
+  // starts the next queued frame; returns the status of the owner's done(), BUSY while
+  // that client keeps the bus for its next chunk.
+  LibXR::ErrorCode OnTransferDone() noexcept;
+
+  bool IsBusy() const noexcept { return busy_.load(std::memory_order_acquire); }
+  bool IsQueued(BusSlot slot) const noexcept;
+  // Slot whose transfer is running, or INVALID_BUS_SLOT.
+  BusSlot Owner() const noexcept;
+  // Bytes of the frames started so far; wraps.
+  uint32_t BytesSent() const noexcept { return clock_.load(std::memory_order_relaxed); }
+
+ protected:
+  struct Entry
+  {
+    BusClient client{};
+    std::atomic<bool> queued{false};
+    uint32_t bytes{0};
+    uint32_t finish{0};
+  };
+
+  BusSchedulerBase() = default;
+
+  // Derived classes own the storage and bind it from their constructor.
+  void BindStorage(Entry* entries, uint8_t capacity) noexcept;
+
+ private:
+  // Runs with busy_ held; releases it when nothing could be started.
+  void Dispatch() noexcept;
+  BusSlot Pick(uint32_t skipped) const noexcept;
+
+  Entry* entries_{nullptr};
+  uint8_t capacity_{0};
+  uint8_t count_{0};
+  std::atomic<bool> busy_{false};
+  std::atomic<BusSlot> owner_{INVALID_BUS_SLOT};
+  std::atomic<uint32_t> clock_{0};
+};
+
+template <uint8_t kClients = 4>
+class BusScheduler : public BusSchedulerBase
+{
+ public:
+  static_assert(kClients > 0 && kClients <= 32, "kClients must be in 1..32.");
+
+  BusScheduler() noexcept { BindStorage(storage_.data(), kClients); }
+
+ private:
+  std::array<Entry, kClients> storage_{};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,689 @@
+#include "draw_list.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+namespace
+{
+
+constexpr uint8_t MAX_COVERS = 4;
+
+// The call leaves every covered pixel unchanged.
+bool draws_nothing(Color color, RasterOp raster_op) noexcept
+{
+  switch (raster_op)
+  {
+    case RasterOp::COPY:
+      return false;
+    case RasterOp::XOR:
+    case RasterOp::OR:
+      return color == Color::BLACK;
+    case RasterOp::AND:
+      return color == Color::WHITE;
+  }
+  return false;
+}
+
+// Every covered pixel ends up the same regardless of what was there.
+bool writes_constant(Color color, RasterOp raster_op) noexcept
+{
+  return raster_op == RasterOp::COPY ||
+         (raster_op == RasterOp::OR && color == Color::WHITE) ||
+         (raster_op == RasterOp::AND && color == Color::BLACK);
+}
+
+bool rect_contains(Rect outer, Rect inner) noexcept
+{
+  const int32_t OUTER_RIGHT = outer.x + static_cast<int32_t>(outer.w);
+  const int32_t OUTER_BOTTOM = outer.y + static_cast<int32_t>(outer.h);
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + static_cast<int32_t>(inner.w) <= OUTER_RIGHT &&
+         inner.y + static_cast<int32_t>(inner.h) <= OUTER_BOTTOM;
+}
+
+Rect line_rect(Point point, int16_t length, bool vertical) noexcept
+{
+  int32_t begin = vertical ? point.y : point.x;
+  int32_t span = length;
+  if (span < 0)
+  {
+    begin += span;
+    span = -span;
+  }
+  if (vertical)
+  {
+    return Rect{point.x, static_cast<int16_t>(begin), 1, static_cast<uint16_t>(span)};
+  }
+  return Rect{static_cast<int16_t>(begin), point.y, static_cast<uint16_t>(span), 1};
+}
+
+// Pixels a command overwrites whatever was drawn there before; empty if none.
+Rect cover_of(const DrawCommand& command, Rect full) noexcept
+{
+  switch (command.op)
+  {
+    case DrawOp::CLEAR:
+      return full;
+    case DrawOp::HLINE:
+    case DrawOp::VLINE:
+    case DrawOp::FILL_RECT:
+      return writes_constant(command.color, command.raster_op) ? command.bounds : Rect{};
+    case DrawOp::BITMAP:
+      if (command.style.bitmap.mode == BitmapMode::OPAQUE &&
+          command.style.bitmap.raster_op == RasterOp::COPY &&
+          command.style.bitmap.mask == nullptr)
+      {
+        return command.bounds;
+      }
+      return Rect{};
+    case DrawOp::GRAY:
+      return (command.data != nullptr) ? command.bounds : Rect{};
+    default:
+      return Rect{};
+  }
+}
+
+bool is_drawing(DrawOp op) noexcept
+{
+  return op != DrawOp::SET_CLIP && op != DrawOp::RESET_CLIP;
+}
+
+}  // namespace
+
+void DrawListBase::BindStorage(DrawCommand* commands, uint16_t capacity) noexcept
+{
+  commands_ = commands;
+  capacity_ = capacity;
+  count_ = 0;
+}
+
+void DrawListBase::Begin(Surface& target) noexcept
+{
+  target_ = &target;
+  clip_ = target.GetClip();
+  count_ = 0;
+  culled_ = 0;
+  recording_ = true;
+  binned_ = false;
+  overflowed_ = false;
+}
+
+void DrawListBase::BeginBinned(Surface& target) noexcept
+{
+  Begin(target);
+  const Size SIZE = target.GetSize();
+  clip_ = Rect{0, 0, SIZE.w, SIZE.h};
+  binned_ = true;
+}
+
+void DrawListBase::End() noexcept
+{
+  if (!binned_)
+  {
+    Flush();
+  }
+  else if (!overflowed_ && target_ != nullptr)
+  {
+    Cull();
+    for (uint16_t i = 0; i < count_; ++i)
+    {
+      culled_ = static_cast<uint16_t>(culled_ + (commands_[i].culled ? 1U : 0U));
+    }
+  }
+  recording_ = false;
+}
+
+void DrawListBase::ReplayBand(Surface& band) noexcept
+{
+  if (!binned_ || recording_ || overflowed_)
+  {
+    return;
+  }
+
+  // The recording started from the full frame clip.
+  band.ResetClip();
+  const Rect ROWS = band.GetClip();
+  for (uint16_t i = 0; i < count_; ++i)
+  {
+    const DrawCommand& command = commands_[i];
+    if (command.culled ||
+        (is_drawing(command.op) && rect_empty(intersect_rect(command.bounds, ROWS))))
+    {
+      continue;
+    }
+    Replay(band, command);
+  }
+}
+
+void DrawListBase::Clear(Color color) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::CLEAR;
+  command.color = color;
+  Push(command);
+}
+
+void DrawListBase::SetClip(Rect rect) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::SET_CLIP;
+  command.p0 = Point{rect.x, rect.y};
+  command.size = Size{rect.w, rect.h};
+  Push(command);
+}
+
+void DrawListBase::ResetClip() noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::RESET_CLIP;
+  Push(command);
+}
+
+void DrawListBase::DrawPixel(Point point, Color color, RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::PIXEL;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = point;
+  command.bounds = Rect{point.x, point.y, 1, 1};
+  Push(command);
+}
+
+void DrawListBase::DrawHLine(Point point, int16_t length, Color color,
+                             RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::HLINE;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = point;
+  command.p1.x = length;
+  command.bounds = line_rect(point, length, false);
+  Push(command);
+}
+
+void DrawListBase::DrawVLine(Point point, int16_t length, Color color,
+                             RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::VLINE;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = point;
+  command.p1.x = length;
+  command.bounds = line_rect(point, length, true);
+  Push(command);
+}
+
+void DrawListBase::DrawLine(Point p0, Point p1, Color color, RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::LINE;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = p0;
+  command.p1 = p1;
+  command.bounds = union_rect(Rect{p0.x, p0.y, 1, 1}, Rect{p1.x, p1.y, 1, 1});
+  Push(command);
+}
+
+void DrawListBase::DrawRect(Rect rect, Color color, RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::RECT;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = Point{rect.x, rect.y};
+  command.size = Size{rect.w, rect.h};
+  command.bounds = rect;
+  Push(command);
+}
+
+void DrawListBase::FillRect(Rect rect, Color color, RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::FILL_RECT;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = Point{rect.x, rect.y};
+  command.size = Size{rect.w, rect.h};
+  command.bounds = rect;
+  Push(command);
+}
+
+void DrawListBase::DrawCircle(Point center, uint8_t radius, Color color,
+                              RasterOp raster_op) noexcept
+{
+  PushRound(DrawOp::CIRCLE, center, Size{radius, radius}, color, raster_op);
+}
+
+void DrawListBase::FillCircle(Point center, uint8_t radius, Color color,
+                              RasterOp raster_op) noexcept
+{
+  PushRound(DrawOp::FILL_CIRCLE, center, Size{radius, radius}, color, raster_op);
+}
+
+void DrawListBase::DrawEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                               Color color, RasterOp raster_op) noexcept
+{
+  PushRound(DrawOp::ELLIPSE, center, Size{radius_x, radius_y}, color, raster_op);
+}
+
+void DrawListBase::FillEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                               Color color, RasterOp raster_op) noexcept
+{
+  PushRound(DrawOp::FILL_ELLIPSE, center, Size{radius_x, radius_y}, color, raster_op);
+}
+
+void DrawListBase::DrawRoundRect(Rect rect, uint8_t radius, Color color,
+                                 RasterOp raster_op) noexcept
+{
+  PushRoundRect(DrawOp::ROUND_RECT, rect, radius, color, raster_op);
+}
+
+void DrawListBase::FillRoundRect(Rect rect, uint8_t radius, Color color,
+                                 RasterOp raster_op) noexcept
+{
+  PushRoundRect(DrawOp::FILL_ROUND_RECT, rect, radius, color, raster_op);
+}
+
+void DrawListBase::DrawPolyline(const Point* points, uint16_t count, Color color,
+                                RasterOp raster_op) noexcept
+{
+  PushPoints(DrawOp::POLYLINE, points, count, color, raster_op);
+}
+
+void DrawListBase::DrawPixels(const Point* points, uint16_t count, Color color,
+                              RasterOp raster_op) noexcept
+{
+  PushPoints(DrawOp::PIXELS, points, count, color, raster_op);
+}
+
+void DrawListBase::FillRects(const Rect* rects, uint16_t count, Color color,
+                             RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::FILL_RECTS;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.data = rects;
+  command.count = (rects != nullptr) ? count : 0;
+  for (uint16_t i = 0; i < command.count; ++i)
+  {
+    command.bounds = union_rect(command.bounds, rects[i]);
+  }
+  Push(command);
+}
+
+void DrawListBase::DrawHistogram(Rect area, const uint8_t* heights, uint16_t count,
+                                 uint8_t bar_width, Color color,
+                                 RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::HISTOGRAM;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = Point{area.x, area.y};
+  command.p1.x = bar_width;
+  command.size = Size{area.w, area.h};
+  command.data = heights;
+  command.count = count;
+  command.bounds = area;
+  Push(command);
+}
+
+void DrawListBase::PushPoints(DrawOp op, const Point* points, uint16_t count,
+                              Color color, RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = op;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.data = points;
+  command.count = (points != nullptr) ? count : 0;
+  for (uint16_t i = 0; i < command.count; ++i)
+  {
+    command.bounds = union_rect(command.bounds, Rect{points[i].x, points[i].y, 1, 1});
+  }
+  Push(command);
+}
+
+void DrawListBase::PushRound(DrawOp op, Point center, Size radii, Color color,
+                             RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = op;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = center;
+  command.size = radii;
+  command.bounds = Rect{
+      static_cast<int16_t>(center.x - radii.w),
+      static_cast<int16_t>(center.y - radii.h),
+      static_cast<uint16_t>(2U * radii.w + 1U),
+      static_cast<uint16_t>(2U * radii.h + 1U),
+  };
+  Push(command);
+}
+
+void DrawListBase::PushRoundRect(DrawOp op, Rect rect, uint8_t radius, Color color,
+                                 RasterOp raster_op) noexcept
+{
+  DrawCommand command{};
+  command.op = op;
+  command.color = color;
+  command.raster_op = raster_op;
+  command.p0 = Point{rect.x, rect.y};
+  command.p1.x = radius;
+  command.size = Size{rect.w, rect.h};
+  command.bounds = rect;
+  Push(command);
+}
+
+void DrawListBase::DrawBitmap(Point point, const uint8_t* bits, Size size,
+                              Color foreground, RasterOp raster_op) noexcept
+{
+  BitmapStyle style{};
+  style.foreground = foreground;
+  style.raster_op = raster_op;
+  DrawBitmap(point, bits, size, style);
+}
+
+void DrawListBase::DrawBitmap(Point point, const uint8_t* bits, Size size,
+                              const BitmapStyle& style) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::BITMAP;
+  command.color = style.foreground;
+  command.raster_op = style.raster_op;
+  command.p0 = point;
+  command.size = size;
+  command.data = bits;
+  command.style.bitmap = style;
+  command.bounds = Rect{point.x, point.y, size.w, size.h};
+  Push(command);
+}
+
+void DrawListBase::DrawGray8(Point point, const uint8_t* gray, Size size,
+                             const GrayStyle& style) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::GRAY;
+  command.p0 = point;
+  command.size = size;
+  command.data = gray;
+  command.style.gray = style;
+  command.bounds = Rect{point.x, point.y, size.w, size.h};
+  Push(command);
+}
+
+void DrawListBase::DrawText(Point baseline_left, const char* text,
+                            const TextStyle& style) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::TEXT;
+  command.color = style.color;
+  command.raster_op = style.raster_op;
+  command.p0 = baseline_left;
+  command.data = text;
+  command.style.text = style;
+  command.bounds = text_bounds(baseline_left, text, style);
+  Push(command);
+}
+
+void DrawListBase::DrawTextTopLeft(Point top_left, const char* text,
+                                   const TextStyle& style) noexcept
+{
+  DrawText(text_baseline(top_left, style), text, style);
+}
+
+void DrawListBase::DrawTextLines(Rect box, const TextLine* lines, uint16_t count,
+                                 const TextStyle& style, TextAlign align) noexcept
+{
+  DrawCommand command{};
+  command.op = DrawOp::TEXT_LINES;
+  command.color = style.color;
+  command.raster_op = style.raster_op;
+  command.p0 = Point{box.x, box.y};
+  command.p1.x = static_cast<int16_t>(align);
+  command.size = Size{box.w, box.h};
+  command.data = lines;
+  command.count = count;
+  command.style.text = style;
+  command.bounds = text_lines_bounds(box, lines, count, style, align);
+  Push(command);
+}
+
+void DrawListBase::Push(DrawCommand& command) noexcept
+{
+  if (!recording_)
+  {
+    if (target_ != nullptr)
+    {
+      Replay(*target_, command);
+    }
+    return;
+  }
+
+  const Size SIZE = target_->GetSize();
+  const Rect FULL{0, 0, SIZE.w, SIZE.h};
+  if (command.op == DrawOp::SET_CLIP)
+  {
+    const Rect CLIP{command.p0.x, command.p0.y, command.size.w, command.size.h};
+    clip_ = intersect_rect(CLIP, FULL);
+  }
+  else if (command.op == DrawOp::RESET_CLIP)
+  {
+    clip_ = FULL;
+  }
+  else if (command.op == DrawOp::CLEAR)
+  {
+    command.bounds = FULL;
+  }
+  else
+  {
+    command.bounds = intersect_rect(command.bounds, clip_);
+  }
+
+  if (count_ == capacity_)
+  {
+    if (binned_)
+    {
+      overflowed_ = true;
+      return;
+    }
+    Flush();
+  }
+  commands_[count_] = command;
+  ++count_;
+}
+
+void DrawListBase::Cull() noexcept
+{
+  const Size SIZE = target_->GetSize();
+  const Rect FULL{0, 0, SIZE.w, SIZE.h};
+
+  // Walk backwards remembering the largest opaque areas drawn later.
+  std::array<Rect, MAX_COVERS> covers{};
+  uint8_t cover_count = 0;
+  for (uint16_t i = count_; i > 0; --i)
+  {
+    DrawCommand& command = commands_[i - 1U];
+    command.culled = false;
+    if (!is_drawing(command.op))
+    {
+      continue;
+    }
+
+    const bool TRANSPARENT_OP =
+        command.op != DrawOp::CLEAR &&
+        !(command.op == DrawOp::BITMAP &&
+          command.style.bitmap.mode == BitmapMode::OPAQUE) &&
+        draws_nothing(command.color, command.raster_op);
+    if (rect_empty(command.bounds) || TRANSPARENT_OP)
+    {
+      command.culled = true;
+      continue;
+    }
+    for (uint8_t c = 0; c < cover_count; ++c)
+    {
+      if (rect_contains(covers[c], command.bounds))
+      {
+        command.culled = true;
+        break;
+      }
+    }
+    if (command.culled)
+    {
+      continue;
+    }
+
+    const Rect COVER = cover_of(command, FULL);
+    if (rect_empty(COVER))
+    {
+      continue;
+    }
+    if (cover_count < MAX_COVERS)
+    {
+      covers[cover_count] = COVER;
+      ++cover_count;
+      continue;
+    }
+    uint8_t smallest = 0;
+    for (uint8_t c = 1; c < cover_count; ++c)
+    {
+      if (static_cast<uint32_t>(covers[c].w) * covers[c].h <
+          static_cast<uint32_t>(covers[smallest].w) * covers[smallest].h)
+      {
+        smallest = c;
+      }
+    }
+    if (static_cast<uint32_t>(COVER.w) * COVER.h >
+        static_cast<uint32_t>(covers[smallest].w) * covers[smallest].h)
+    {
+      covers[smallest] = COVER;
+    }
+  }
+}
+
+void DrawListBase::Flush() noexcept
+{
+  if (target_ == nullptr || count_ == 0)
+  {
+    count_ = 0;
+    return;
+  }
+
+  Cull();
+  for (uint16_t i = 0; i < count_; ++i)
+  {
+    if (commands_[i].culled)
+    {
+      ++culled_;
+      continue;
+    }
+    Replay(*target_, commands_[i]);
+  }
+  count_ = 0;
+}
+
+void DrawListBase::Replay(Surface& target, const DrawCommand& command) noexcept
+{
+  const Rect RECT{command.p0.x, command.p0.y, command.size.w, command.size.h};
+  switch (command.op)
+  {
+    case DrawOp::CLEAR:
+      target.Clear(command.color);
+      break;
+    case DrawOp::SET_CLIP:
+      target.SetClip(RECT);
+      break;
+    case DrawOp::RESET_CLIP:
+      target.ResetClip();
+      break;
+    case DrawOp::PIXEL:
+      target.DrawPixel(command.p0, command.color, command.raster_op);
+      break;
+    case DrawOp::HLINE:
+      target.DrawHLine(command.p0, command.p1.x, command.color, command.raster_op);
+      break;
+    case DrawOp::VLINE:
+      target.DrawVLine(command.p0, command.p1.x, command.color, command.raster_op);
+      break;
+    case DrawOp::LINE:
+      target.DrawLine(command.p0, command.p1, command.color, command.raster_op);
+      break;
+    case DrawOp::RECT:
+      target.DrawRect(RECT, command.color, command.raster_op);
+      break;
+    case DrawOp::FILL_RECT:
+      target.FillRect(RECT, command.color, command.raster_op);
+      break;
+    case DrawOp::CIRCLE:
+      target.DrawCircle(command.p0, static_cast<uint8_t>(command.size.w), command.color,
+                        command.raster_op);
+      break;
+    case DrawOp::FILL_CIRCLE:
+      target.FillCircle(command.p0, static_cast<uint8_t>(command.size.w), command.color,
+                        command.raster_op);
+      break;
+    case DrawOp::ELLIPSE:
+      target.DrawEllipse(command.p0, static_cast<uint8_t>(command.size.w),
+                         static_cast<uint8_t>(command.size.h), command.color,
+                         command.raster_op);
+      break;
+    case DrawOp::FILL_ELLIPSE:
+      target.FillEllipse(command.p0, static_cast<uint8_t>(command.size.w),
+                         static_cast<uint8_t>(command.size.h), command.color,
+                         command.raster_op);
+      break;
+    case DrawOp::ROUND_RECT:
+      target.DrawRoundRect(RECT, static_cast<uint8_t>(command.p1.x), command.color,
+                           command.raster_op);
+      break;
+    case DrawOp::FILL_ROUND_RECT:
+      target.FillRoundRect(RECT, static_cast<uint8_t>(command.p1.x), command.color,
+                           command.raster_op);
+      break;
+    case DrawOp::POLYLINE:
+      target.DrawPolyline(static_cast<const Point*>(command.data), command.count,
+                          command.color, command.raster_op);
+      break;
+    case DrawOp::PIXELS:
+      target.DrawPixels(static_cast<const Point*>(command.data), command.count,
+                        command.color, command.raster_op);
+      break;
+    case DrawOp::FILL_RECTS:
+      target.FillRects(static_cast<const Rect*>(command.data), command.count,
+                       command.color, command.raster_op);
+      break;
+    case DrawOp::HISTOGRAM:
+      target.DrawHistogram(RECT, static_cast<const uint8_t*>(command.data), command.count,
+                           static_cast<uint8_t>(command.p1.x), command.color,
+                           command.raster_op);
+      break;
+    case DrawOp::BITMAP:
+      target.DrawBitmap(command.p0, static_cast<const uint8_t*>(command.data),
+                        command.size, command.style.bitmap);
+      break;
+    case DrawOp::GRAY:
+      target.DrawGray8(command.p0, static_cast<const uint8_t*>(command.data),
+                       command.size, command.style.gray);
+      break;
+    case DrawOp::TEXT:
+      target.DrawText(command.p0, static_cast<const char*>(command.data),
+                      command.style.text);
+      break;
+    case DrawOp::TEXT_LINES:
+      target.DrawTextLines(RECT, static_cast<const TextLine*>(command.data),
+                           command.count, command.style.text,
+                           static_cast<TextAlign>(command.p1.x));
+      break;
+  }
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
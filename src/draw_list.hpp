@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "surface.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+enum class DrawOp : uint8_t
+{
+  CLEAR,
+  SET_CLIP,
+  RESET_CLIP,
+  PIXEL,
+  HLINE,
+  VLINE,
+  LINE,
+  RECT,
+  FILL_RECT,
+  CIRCLE,
+  FILL_CIRCLE,
+  ELLIPSE,
+  FILL_ELLIPSE,
+  ROUND_RECT,
+  FILL_ROUND_RECT,
+  POLYLINE,
+  PIXELS,
+  FILL_RECTS,
+  HISTOGRAM,
+  BITMAP,
+  GRAY,
+  TEXT,
+  TEXT_LINES
+};
+
+// One recorded Surface call. Pointers (bitmap bits, mask, gray samples and errors, text,
+// font, batch arrays) are stored, not copied, and must stay valid until the list is
+// replayed.
+struct DrawCommand
+{
+  DrawOp op{DrawOp::CLEAR};
+  Color color{Color::WHITE};
+  RasterOp raster_op{RasterOp::COPY};
+  bool culled{false};
+  Rect bounds{};  // Logical pixels the call may write, clipped as recorded.
+  Point p0{};     // Point, line start, rect/bitmap origin, circle centre, text baseline.
+  Point p1{};     // Line end; p1.x is the H/V line length, round rect radius or align.
+  Size size{};    // Rect/bitmap/box size; circle radius in w, ellipse radii in w and h.
+  const void* data{nullptr};  // Bitmap bits, text or batch elements.
+  uint16_t count{0};          // Batch elements; p1.x holds the histogram bar width.
+
+  union Style
+  {
+    Style() noexcept : text{} {}
+    BitmapStyle bitmap;
+    GrayStyle gray;
+    TextStyle text;
+  } style;
+};
+
+// Records Surface calls between Begin() and End() and replays them at End() in
+// recorded order, skipping calls that draw nothing or that a later opaque fill or
+// Clear() fully covers. A full list is replayed early and recording continues.
+// Outside Begin()/End() calls draw straight to the last target.
+class DrawListBase
+{
+ public:
+  DrawListBase(const DrawListBase&) = delete;
+  DrawListBase& operator=(const DrawListBase&) = delete;
+
+  void Begin(Surface& target) noexcept;
+  void End() noexcept;
+
+  // Records a whole frame for band-by-band replay; target only has to report the frame
+  // size. End() culls but draws nothing, and a full list drops further calls and
+  // reports Overflowed() instead of flushing.
+  void BeginBinned(Surface& target) noexcept;
+  bool Overflowed() const noexcept { return overflowed_; }
+  // Replays the calls whose bounds meet the rows band is bound to, clipped by the
+  // band. Needs a finished BeginBinned() recording that did not overflow.
+  void ReplayBand(Surface& band) noexcept;
+
+  bool IsRecording() const noexcept { return recording_; }
+  uint16_t Count() const noexcept { return count_; }
+  uint16_t Capacity() const noexcept { return capacity_; }
+  // Calls skipped by the replays since Begin().
+  uint16_t CulledCount() const noexcept { return culled_; }
+
+  void Clear(Color color = Color::BLACK) noexcept;
+  void SetClip(Rect rect) noexcept;
+  void ResetClip() noexcept;
+
+  void DrawPixel(Point point, Color color = Color::WHITE,
+                 RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawHLine(Point point, int16_t length, Color color = Color::WHITE,
+                 RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawVLine(Point point, int16_t length, Color color = Color::WHITE,
+                 RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawLine(Point p0, Point p1, Color color = Color::WHITE,
+                RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawRect(Rect rect, Color color = Color::WHITE,
+                RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillRect(Rect rect, Color color = Color::WHITE,
+                RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawCircle(Point center, uint8_t radius, Color color = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillCircle(Point center, uint8_t radius, Color color = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                   Color color = Color::WHITE,
+                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                   Color color = Color::WHITE,
+                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawRoundRect(Rect rect, uint8_t radius, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillRoundRect(Rect rect, uint8_t radius, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawPolyline(const Point* points, uint16_t count, Color color = Color::WHITE,
+                    RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawPixels(const Point* points, uint16_t count, Color color = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillRects(const Rect* rects, uint16_t count, Color color = Color::WHITE,
+                 RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawHistogram(Rect area, const uint8_t* heights, uint16_t count,
+                     uint8_t bar_width = 1, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawBitmap(Point point, const uint8_t* bits, Size size,
+                  Color foreground = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawBitmap(Point point, const uint8_t* bits, Size size,
+                  const BitmapStyle& style) noexcept;
+  void DrawGray8(Point point, const uint8_t* gray, Size size,
+                 const GrayStyle& style = GrayStyle{}) noexcept;
+  void DrawText(Point baseline_left, const char* text, const TextStyle& style) noexcept;
+  void DrawTextTopLeft(Point top_left, const char* text, const TextStyle& style) noexcept;
+  void DrawTextLines(Rect box, const TextLine* lines, uint16_t count,
+                     const TextStyle& style, TextAlign align = TextAlign::LEFT) noexcept;
+
+ protected:
+  DrawListBase() = default;
+
+  // Derived classes own the storage and bind it from their constructor.
+  void BindStorage(DrawCommand* commands, uint16_t capacity) noexcept;
+
+ private:
+  void Push(DrawCommand& command) noexcept;
+  void PushRound(DrawOp op, Point center, Size radii, Color color,
+                 RasterOp raster_op) noexcept;
+  void PushPoints(DrawOp op, const Point* points, uint16_t count, Color color,
+                  RasterOp raster_op) noexcept;
+  void PushRoundRect(DrawOp op, Rect rect, uint8_t radius, Color color,
+                     RasterOp raster_op) noexcept;
+  void Flush() noexcept;
+  void Cull() noexcept;
+  static void Replay(Surface& target, const DrawCommand& command) noexcept;
+
+  DrawCommand* commands_{nullptr};
+  uint16_t capacity_{0};
+  uint16_t count_{0};
+  uint16_t culled_{0};
+  Surface* target_{nullptr};
+  Rect clip_{};  // Clip the recorded calls will see.
+  bool recording_{false};
+  bool binned_{false};
+  bool overflowed_{false};
+};
+
+template <uint16_t kCommands = 64>
+class DrawList : public DrawListBase
+{
+ public:
+  static_assert(kCommands > 0, "kCommands must be greater than 0.");
+
+  DrawList() noexcept { BindStorage(storage_.data(), kCommands); }
+
+ private:
+  std::array<DrawCommand, kCommands> storage_{};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
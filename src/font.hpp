@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace LibXR
@@ -7,16 +8,163 @@ namespace LibXR
 namespace MonoGL
 {
 
+enum class FontFormat : uint8_t
+{
+  FIXED = 0,  // glyph_width x glyph_height bitmaps packed by row, 1bpp.
+  RLE = 1     // Proportional glyphs described by glyph_table, run-length coded.
+};
+
+// One glyph of an RLE font. The box is placed relative to the pen on the baseline:
+// x_offset to the right, y_offset up to its top row.
+//
+// The bitmap starts at glyphs[Offset()] and is read MSB-first. It is a sequence of
+// pairs: zero_bits bits of unset pixels, then one_bits bits of set pixels, scanning
+// the box row by row. Each pair is followed by one bit per repeat: 1 emits the pair
+// again, 0 moves on to the next pair. The glyph ends after width * height pixels.
+struct FontGlyph
+{
+  // Byte offset into glyphs, 24-bit little-endian so the record packs into 8 bytes.
+  uint8_t offset[3]{0, 0, 0};
+  uint8_t width{0};
+  uint8_t height{0};
+  int8_t x_offset{0};
+  int8_t y_offset{0};
+  uint8_t advance{0};
+
+  constexpr uint32_t Offset() const noexcept
+  {
+    return static_cast<uint32_t>(offset[0]) | (static_cast<uint32_t>(offset[1]) << 8U) |
+           (static_cast<uint32_t>(offset[2]) << 16U);
+  }
+};
+
+static_assert(sizeof(FontGlyph) == 8U, "FontGlyph must stay 8 bytes.");
+
+// Codepoints first .. first + count - 1 map to glyphs glyph_index onwards.
+struct FontRange
+{
+  uint32_t first{0};
+  uint16_t count{0};
+  uint16_t glyph_index{0};
+};
+
 struct Font
 {
-  uint8_t glyph_width{0};
-  uint8_t glyph_height{0};
+  uint8_t glyph_width{0};   // RLE: widest box or advance; advance of missing glyphs.
+  uint8_t glyph_height{0};  // RLE: tallest box.
   uint8_t first_char{32};
   uint8_t last_char{126};
   uint8_t ascent{0};
   uint8_t descent{0};
-  const uint8_t* glyphs{nullptr};  // Packed by row, 1bpp.
+  const uint8_t* glyphs{nullptr};  // FIXED: packed by row, 1bpp. RLE: run data.
+  FontFormat format{FontFormat::FIXED};
+  const FontGlyph* glyph_table{nullptr};  // RLE: one entry per glyph.
+  uint8_t zero_bits{0};                   // RLE: bits per unset run length.
+  uint8_t one_bits{0};                    // RLE: bits per set run length.
+  // Sparse glyph sets: codepoint ranges sorted by first, replacing first_char and
+  // last_char when set.
+  const FontRange* ranges{nullptr};
+  uint16_t range_count{0};
 };
 
+// Finds the glyph of codepoint; a binary search over the ranges of sparse fonts.
+inline bool font_glyph_index(const Font& font, uint32_t codepoint,
+                             uint16_t& glyph_index) noexcept
+{
+  if (font.ranges == nullptr)
+  {
+    if (codepoint < font.first_char || codepoint > font.last_char)
+    {
+      return false;
+    }
+    glyph_index = static_cast<uint16_t>(codepoint - font.first_char);
+    return true;
+  }
+
+  uint16_t low = 0;
+  uint16_t high = font.range_count;
+  while (low < high)
+  {
+    const uint16_t MID = static_cast<uint16_t>(low + (high - low) / 2U);
+    const FontRange& RANGE = font.ranges[MID];
+    if (codepoint < RANGE.first)
+    {
+      high = MID;
+    }
+    else if (codepoint - RANGE.first >= RANGE.count)
+    {
+      low = static_cast<uint16_t>(MID + 1U);
+    }
+    else
+    {
+      glyph_index = static_cast<uint16_t>(RANGE.glyph_index + (codepoint - RANGE.first));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decodes the UTF-8 sequence at text and advances past it. Malformed, overlong or
+// truncated sequences yield their first byte as a codepoint (Latin-1), so 8-bit
+// strings keep working.
+inline uint32_t utf8_next(const char*& text) noexcept
+{
+  const auto* p = reinterpret_cast<const uint8_t*>(text);
+  const uint8_t LEAD = p[0];
+  uint8_t length = 0;
+  uint32_t codepoint = 0;
+  uint32_t min_codepoint = 0;
+  if (LEAD < 0x80U)
+  {
+    text += 1;
+    return LEAD;
+  }
+  if ((LEAD & 0xE0U) == 0xC0U)
+  {
+    length = 2;
+    codepoint = LEAD & 0x1FU;
+    min_codepoint = 0x80U;
+  }
+  else if ((LEAD & 0xF0U) == 0xE0U)
+  {
+    length = 3;
+    codepoint = LEAD & 0x0FU;
+    min_codepoint = 0x800U;
+  }
+  else if ((LEAD & 0xF8U) == 0xF0U)
+  {
+    length = 4;
+    codepoint = LEAD & 0x07U;
+    min_codepoint = 0x10000U;
+  }
+
+  // A NUL is never a continuation byte, so this stops at the end of the string.
+  uint8_t i = 1;
+  for (; i < length && (p[i] & 0xC0U) == 0x80U; ++i)
+  {
+    codepoint = (codepoint << 6U) | (p[i] & 0x3FU);
+  }
+  if (length == 0 || i != length || codepoint < min_codepoint || codepoint > 0x10FFFFU ||
+      (codepoint >= 0xD800U && codepoint <= 0xDFFFU))
+  {
+    text += 1;
+    return LEAD;
+  }
+  text += length;
+  return codepoint;
+}
+
+inline uint16_t font_glyph_row_bytes(const Font& font) noexcept
+{
+  return static_cast<uint16_t>((font.glyph_width + 7U) / 8U);
+}
+
+// glyph_index as found by font_glyph_index(). FIXED fonts only.
+inline const uint8_t* font_glyph_bits(const Font& font, uint16_t glyph_index) noexcept
+{
+  return font.glyphs + static_cast<std::size_t>(glyph_index) *
+                           font_glyph_row_bytes(font) * font.glyph_height;
+}
+
 }  // namespace MonoGL
 }  // namespace LibXR
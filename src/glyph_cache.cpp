@@ -0,0 +1,81 @@
+#include "glyph_cache.hpp"
+
+#include <cstring>
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+void expand_row_bits(const uint8_t* src, uint16_t width, uint8_t scale,
+                     uint8_t* dst) noexcept
+{
+  const uint32_t OUT_BITS = static_cast<uint32_t>(width) * scale;
+  std::memset(dst, 0, (OUT_BITS + 7U) / 8U);
+
+  uint32_t out = 0;
+  for (uint16_t x = 0; x < width; ++x)
+  {
+    const bool SET = (src[x / 8U] & (0x80U >> (x & 0x7U))) != 0U;
+    if (!SET)
+    {
+      out += scale;
+      continue;
+    }
+    for (uint8_t i = 0; i < scale; ++i, ++out)
+    {
+      dst[out / 8U] |= static_cast<uint8_t>(0x80U >> (out & 0x7U));
+    }
+  }
+}
+
+void GlyphCache::BindStorage(SlotTag* tags, uint8_t* data, uint8_t slot_count,
+                             uint16_t slot_bytes) noexcept
+{
+  tags_ = tags;
+  data_ = data;
+  slot_count_ = slot_count;
+  slot_bytes_ = slot_bytes;
+}
+
+const uint8_t* GlyphCache::Lookup(const Font& font, uint16_t glyph_index,
+                                  uint8_t scale_x) noexcept
+{
+  const uint16_t ROW_BYTES = static_cast<uint16_t>(
+      (static_cast<uint32_t>(font.glyph_width) * scale_x + 7U) / 8U);
+  const uint32_t GLYPH_BYTES = static_cast<uint32_t>(ROW_BYTES) * font.glyph_height;
+  if (slot_count_ == 0 || GLYPH_BYTES > slot_bytes_ || font.format != FontFormat::FIXED)
+  {
+    return nullptr;
+  }
+
+  const uint8_t SLOT = static_cast<uint8_t>((glyph_index * 7U + scale_x) %
+                                            static_cast<uint32_t>(slot_count_));
+  uint8_t* data = data_ + static_cast<std::size_t>(SLOT) * slot_bytes_;
+  SlotTag& tag = tags_[SLOT];
+  if (tag.font == &font && tag.glyph_index == glyph_index && tag.scale_x == scale_x)
+  {
+    return data;
+  }
+
+  const uint8_t* glyph = font_glyph_bits(font, glyph_index);
+  const uint16_t SRC_ROW_BYTES = font_glyph_row_bytes(font);
+  for (uint8_t y = 0; y < font.glyph_height; ++y)
+  {
+    expand_row_bits(glyph + static_cast<std::size_t>(y) * SRC_ROW_BYTES, font.glyph_width,
+                    scale_x, data + static_cast<std::size_t>(y) * ROW_BYTES);
+  }
+  tag = SlotTag{&font, glyph_index, scale_x};
+  return data;
+}
+
+void GlyphCache::Invalidate() noexcept
+{
+  for (uint8_t i = 0; i < slot_count_; ++i)
+  {
+    tags_[i] = SlotTag{};
+  }
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
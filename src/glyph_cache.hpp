@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "font.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+// Writes width source bits (1bpp, MSB-first) with every bit repeated scale times.
+void expand_row_bits(const uint8_t* src, uint16_t width, uint8_t scale,
+                     uint8_t* dst) noexcept;
+
+// Direct-mapped cache of glyphs pre-expanded along x for TextStyle::scale_x > 1.
+// Each glyph is stored as glyph_height MSB-first rows of
+// ceil(glyph_width * scale_x / 8) bytes; scale_y is applied while blitting.
+class GlyphCache
+{
+ public:
+  GlyphCache(const GlyphCache&) = delete;
+  GlyphCache& operator=(const GlyphCache&) = delete;
+
+  // Returns the expanded glyph, filling its slot on a miss, or nullptr when the
+  // expanded glyph is larger than a slot or the font is not FontFormat::FIXED.
+  const uint8_t* Lookup(const Font& font, uint16_t glyph_index, uint8_t scale_x) noexcept;
+  void Invalidate() noexcept;
+
+ protected:
+  struct SlotTag
+  {
+    const Font* font{nullptr};
+    uint16_t glyph_index{0};
+    uint8_t scale_x{0};
+  };
+
+  GlyphCache() = default;
+  void BindStorage(SlotTag* tags, uint8_t* data, uint8_t slot_count,
+                   uint16_t slot_bytes) noexcept;
+
+ private:
+  SlotTag* tags_{nullptr};
+  uint8_t* data_{nullptr};
+  uint8_t slot_count_{0};
+  uint16_t slot_bytes_{0};
+};
+
+template <uint8_t kSlots = 8, uint16_t kSlotBytes = 64>
+class StaticGlyphCache : public GlyphCache
+{
+ public:
+  static_assert(kSlots > 0, "kSlots must be greater than 0.");
+  static_assert(kSlotBytes > 0, "kSlotBytes must be greater than 0.");
+
+  StaticGlyphCache() noexcept
+  {
+    BindStorage(tags_.data(), data_.data(), kSlots, kSlotBytes);
+  }
+
+ private:
+  std::array<SlotTag, kSlots> tags_{};
+  std::array<uint8_t, static_cast<std::size_t>(kSlots) * kSlotBytes> data_{};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,143 @@
+#include "gray_surface.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+void GraySurfaceBase::BindStorage(uint8_t* low, uint8_t* high,
+                                  std::size_t plane_bytes) noexcept
+{
+  bits_[LOW_PLANE] = low;
+  bits_[HIGH_PLANE] = high;
+  plane_bytes_ = plane_bytes;
+}
+
+void GraySurfaceBase::Clear(uint8_t level) noexcept
+{
+  Draw(level, [](Surface& plane, Color color) { plane.Clear(color); });
+}
+
+void GraySurfaceBase::DrawPixel(Point point, uint8_t level) noexcept
+{
+  Draw(level, [point](Surface& plane, Color color) { plane.DrawPixel(point, color); });
+}
+
+void GraySurfaceBase::FillRect(Rect rect, uint8_t level) noexcept
+{
+  Draw(level, [rect](Surface& plane, Color color) { plane.FillRect(rect, color); });
+}
+
+uint8_t GraySurfaceBase::NextPlane() const noexcept
+{
+  return (phase_ < PHASES - 1U) ? HIGH_PLANE : LOW_PLANE;
+}
+
+bool GraySurfaceBase::Bind(Size panel, uint16_t stride_bytes, PixelLayout layout,
+                           Rotation rotation) noexcept
+{
+  const std::size_t REQUIRED_BYTES =
+      static_cast<std::size_t>(stride_bytes) *
+      static_cast<std::size_t>(layout_line_count(panel.h, layout));
+  if (bits_[LOW_PLANE] == nullptr || REQUIRED_BYTES > plane_bytes_)
+  {
+    return false;
+  }
+  panel_ = panel;
+  stride_bytes_ = stride_bytes;
+  layout_ = layout;
+  for (uint8_t plane = 0; plane < 2U; ++plane)
+  {
+    planes_[plane].Bind(bits_[plane], panel, stride_bytes, layout);
+    planes_[plane].SetRotation(rotation);
+    planes_[plane].ClearDirtyRect();
+  }
+  // Whatever the planes held before is scanned once.
+  mixed_.Clear();
+  mixed_.Add(Rect{0, 0, panel.w, panel.h});
+  phase_ = 0;
+  restage_ = true;
+  bound_ = true;
+  return true;
+}
+
+void GraySurfaceBase::SetRotation(Rotation rotation) noexcept
+{
+  for (Surface& plane : planes_)
+  {
+    plane.SetRotation(rotation);
+  }
+  restage_ = true;
+}
+
+const uint8_t* GraySurfaceBase::StageNextPhase(DirtyRegion& region) noexcept
+{
+  const uint8_t NEXT = NextPlane();
+  UpdateMixed();
+
+  region.Clear();
+  if (restage_)
+  {
+    region.Add(Rect{0, 0, panel_.w, panel_.h});
+    restage_ = false;
+  }
+  else
+  {
+    // The frame holds staged_plane_ as it was at the last stage. Outside what either
+    // plane drew since, NEXT differs from it only where the planes differ now.
+    const DirtyRegion& drawn = planes_[NEXT].GetDirtyRegion();
+    for (uint8_t i = 0; i < drawn.Count(); ++i)
+    {
+      region.Add(drawn.Rects()[i]);
+    }
+    if (NEXT != staged_plane_)
+    {
+      const DirtyRegion& other = planes_[staged_plane_].GetDirtyRegion();
+      for (uint8_t i = 0; i < other.Count(); ++i)
+      {
+        region.Add(other.Rects()[i]);
+      }
+      for (uint8_t i = 0; i < mixed_.Count(); ++i)
+      {
+        region.Add(mixed_.Rects()[i]);
+      }
+    }
+  }
+  planes_[LOW_PLANE].ClearDirtyRect();
+  planes_[HIGH_PLANE].ClearDirtyRect();
+  staged_plane_ = NEXT;
+  return bits_[NEXT];
+}
+
+void GraySurfaceBase::AdvancePhase() noexcept
+{
+  phase_ = static_cast<uint8_t>((phase_ + 1U) % PHASES);
+}
+
+void GraySurfaceBase::UpdateMixed() noexcept
+{
+  DirtyRegion scan = mixed_;
+  bool drawn = false;
+  for (const Surface& plane : planes_)
+  {
+    const DirtyRegion& dirty = plane.GetDirtyRegion();
+    for (uint8_t i = 0; i < dirty.Count(); ++i)
+    {
+      scan.Add(dirty.Rects()[i]);
+      drawn = true;
+    }
+  }
+  if (!drawn && !restage_)
+  {
+    return;
+  }
+  mixed_.Clear();
+  for (uint8_t i = 0; i < scan.Count(); ++i)
+  {
+    diff_frames(bits_[HIGH_PLANE], bits_[LOW_PLANE], panel_, stride_bytes_, layout_,
+                scan.Rects()[i], mixed_, nullptr);
+  }
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
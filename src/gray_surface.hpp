@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "surface.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+// Four gray levels on a 1bpp panel by frame-rate modulation. Level bit 0 is the low
+// plane and bit 1 the high plane; a cycle of PHASES frames shows the high plane twice and
+// the low plane once, so a pixel is lit in level of every three frames (0 black, 3
+// white). Present::AttachGray() binds the planes and Present::PresentGrayPhase() sends
+// one phase per call.
+//
+// Each plane tracks its own damage. A phase only sends what differs from the frame on
+// the panel: what was drawn into the plane it shows and, when it switches planes, the
+// areas where the planes differ (true gray). Black and white areas are not resent.
+class GraySurfaceBase
+{
+ public:
+  static constexpr uint8_t LEVELS = 4;
+  static constexpr uint8_t PHASES = 3;
+  static constexpr uint8_t LOW_PLANE = 0;
+  static constexpr uint8_t HIGH_PLANE = 1;
+
+  GraySurfaceBase(const GraySurfaceBase&) = delete;
+  GraySurfaceBase& operator=(const GraySurfaceBase&) = delete;
+
+  // Plane surfaces share the panel geometry and rotation; draw into both with Draw().
+  Surface& Plane(uint8_t plane) noexcept { return planes_[plane & 1U]; }
+
+  // Runs draw(surface, color) on each plane with that plane's bit of level.
+  template <typename DrawFn>
+  void Draw(uint8_t level, DrawFn&& draw) noexcept
+  {
+    draw(planes_[LOW_PLANE], (level & 1U) != 0U ? Color::WHITE : Color::BLACK);
+    draw(planes_[HIGH_PLANE], (level & 2U) != 0U ? Color::WHITE : Color::BLACK);
+  }
+
+  void Clear(uint8_t level) noexcept;
+  void DrawPixel(Point point, uint8_t level) noexcept;
+  void FillRect(Rect rect, uint8_t level) noexcept;
+
+  uint8_t Phase() const noexcept { return phase_; }
+  // Plane the next phase shows.
+  uint8_t NextPlane() const noexcept;
+  bool IsBound() const noexcept { return bound_; }
+
+  // Called by Present. Bind() fails when the planes are too small for the panel.
+  bool Bind(Size panel, uint16_t stride_bytes, PixelLayout layout,
+            Rotation rotation) noexcept;
+  void SetRotation(Rotation rotation) noexcept;
+  // Fills region with the panel rects where a frame that holds the last staged plane
+  // differs from NextPlane(), and returns that plane's bits. The plane damage is used up.
+  const uint8_t* StageNextPhase(DirtyRegion& region) noexcept;
+  // The staged phase was accepted; the next call stages the one after it.
+  void AdvancePhase() noexcept;
+
+ protected:
+  GraySurfaceBase() = default;
+
+  // Derived classes own the storage and bind it from their constructor.
+  void BindStorage(uint8_t* low, uint8_t* high, std::size_t plane_bytes) noexcept;
+
+ private:
+  // Rebuilds mixed_ over its old rects and the newly drawn ones.
+  void UpdateMixed() noexcept;
+
+  std::array<uint8_t*, 2> bits_{};
+  std::size_t plane_bytes_{0};
+  std::array<Surface, 2> planes_{};
+  Size panel_{};
+  uint16_t stride_bytes_{0};
+  PixelLayout layout_{PixelLayout::ROW_MAJOR_MSB};
+  DirtyRegion mixed_{};  // Covers every pixel where the planes differ.
+  uint8_t phase_{0};
+  uint8_t staged_plane_{HIGH_PLANE};
+  bool restage_{true};  // The frame holds no plane yet.
+  bool bound_{false};
+};
+
+template <std::size_t kPlaneBytes>
+class GraySurface : public GraySurfaceBase
+{
+ public:
+  static_assert(kPlaneBytes > 0, "kPlaneBytes must be greater than 0.");
+
+  GraySurface() noexcept
+  {
+    BindStorage(storage_[LOW_PLANE].data(), storage_[HIGH_PLANE].data(), kPlaneBytes);
+  }
+
+ private:
+  std::array<std::array<uint8_t, kPlaneBytes>, 2> storage_{};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
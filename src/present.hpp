@@ -4,21 +4,41 @@
 #include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdlib>
 #include <utility>
 
+#include "bus_scheduler.hpp"
+#include "draw_list.hpp"
+#include "gray_surface.hpp"
 #include "libxr_def.hpp"
+#include "present_stats.hpp"
 #include "present_types.hpp"
+#include "transfer_chunks.hpp"
 
 namespace LibXR
 {
 namespace MonoGL
 {
 
-template <typename Backend, std::size_t kFramebufferBytes>
-class Present
+// kBuffers framebuffers of kFramebufferBytes each:
+//   1: async presents wait for their transfer and DIFF presents as AUTO.
+//   2: drawing goes on while the previous frame transfers; a present meanwhile is BUSY
+//      or latched by QueueFrame().
+//   3: a present during a transfer waits in a mailbox buffer, replacing a frame still
+//      waiting there, so neither drawing nor presenting blocks.
+// Stats receives timing and traffic hooks; see present_stats.hpp. It is a private base
+// rather than a member, so the empty NullStats takes no storage.
+template <typename Backend, std::size_t kFramebufferBytes, uint8_t kBuffers = 2,
+          typename Stats = NullStats>
+class Present : private Stats
 {
  public:
   static_assert(kFramebufferBytes > 0, "kFramebufferBytes must be greater than 0.");
+  static_assert(kBuffers >= 1 && kBuffers <= 3, "kBuffers must be 1, 2 or 3.");
+
+  // Runs in OnTransferDone() context once a transfer has completed. status is the result
+  // of starting the queued frame, or OK when none was queued.
+  using FrameDoneCallback = void (*)(void* context, LibXR::ErrorCode status);
 
   // Backend is owned by value. Use a handle-type backend or a correctly movable backend.
   Present(Backend backend, DisplayConfig config)
@@ -30,7 +50,9 @@ class Present
       initialized_ = false;
       return;
     }
-    if (cfg_.buffer_mode == BufferMode::PAGE && cfg_.page_rows == 0)
+    if (cfg_.buffer_mode == BufferMode::PAGE &&
+        (cfg_.page_rows == 0 ||
+         (cfg_.layout == PixelLayout::VERTICAL_PAGE && (cfg_.page_rows % 8U) != 0U)))
     {
       ASSERT(false);
       initialized_ = false;
@@ -54,9 +76,18 @@ class Present
     }
 
     caps_ = backend_.Caps();
+    if (caps_.max_chunk_bytes != 0U && !caps_.partial_update)
+    {
+      ASSERT(false);
+      initialized_ = false;
+      return;
+    }
     draw_buffer_index_ = 0;
     transfer_in_progress_.store(false, std::memory_order_relaxed);
     BindDrawSurface();
+    surface_.SetRotation(cfg_.rotation);
+    surface_.EnablePageDirty(cfg_.enable_page_dirty_tracking &&
+                             PageCount(cfg_) <= PageDirtyMap::MAX_PAGES);
     ClearAllBuffers();
     surface_.AddDirtyRect(FullRect(cfg_));
     initialized_ = true;
@@ -76,12 +107,30 @@ class Present
 
   const Backend& GetBackend() const noexcept { return backend_; }
 
+  Stats& GetStats() noexcept { return *this; }
+
+  const Stats& GetStats() const noexcept { return *this; }
+
   bool IsTransferInProgress() const noexcept
   {
     return transfer_in_progress_.load(std::memory_order_acquire);
   }
 
+  // True while a QueueFrame() frame waits for the running transfer. The surface is
+  // rebound when it starts, so it must not be drawn to until this turns false (on a bus,
+  // see AttachBus()).
+  bool IsFramePending() const noexcept { return frame_pending_.load(); }
+
+  void SetFrameDoneCallback(FrameDoneCallback callback, void* context) noexcept
+  {
+    frame_done_context_ = context;
+    frame_done_callback_ = callback;
+  }
+
   // Call this from DMA/SPI transfer-complete ISR when caps.async_present == true.
+  // Starts the next chunk of a chunked frame, or else the frame waiting in the mailbox or
+  // latched by QueueFrame().
+  // If a chunk fails to start, its frame ends there and the callback gets the error.
   LibXR::ErrorCode OnTransferDone() noexcept
   {
     if (!initialized_)
@@ -93,15 +142,153 @@ class Present
       return LibXR::ErrorCode::NOT_SUPPORT;
     }
 
+    if (!transfer_in_progress_.load(std::memory_order_acquire))
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    const LibXR::ErrorCode CHUNK = SendNextChunk();
+    if (CHUNK == LibXR::ErrorCode::OK)
+    {
+      return LibXR::ErrorCode::OK;
+    }
+
     bool expected = true;
-    if (!transfer_in_progress_.compare_exchange_strong(
-            expected, false, std::memory_order_acq_rel, std::memory_order_acquire))
+    if (!transfer_in_progress_.compare_exchange_strong(expected, false))
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    GetStats().OnTransferDone();
+
+    LibXR::ErrorCode status =
+        (CHUNK == LibXR::ErrorCode::EMPTY) ? LibXR::ErrorCode::OK : CHUNK;
+    // On a bus the scheduler starts queued frames.
+    bool pending = true;
+    if (kBuffers >= 3 && mailbox_full_.exchange(false, std::memory_order_acq_rel))
+    {
+      const LibXR::ErrorCode STATUS = StartMailboxFrame();
+      status = (status == LibXR::ErrorCode::OK) ? STATUS : status;
+    }
+    else if (bus_ == nullptr && frame_pending_.compare_exchange_strong(pending, false))
+    {
+      const LibXR::ErrorCode STATUS =
+          SubmitFrame(pending_region_, pending_mode_, pending_pages_);
+      status = (status == LibXR::ErrorCode::OK) ? STATUS : status;
+    }
+    if (frame_done_callback_ != nullptr)
+    {
+      frame_done_callback_(frame_done_context_, status);
+    }
+    return status;
+  }
+
+  // Shares a bus with other displays; needs caps.async_present, two or more buffers and
+  // Full mode. Presents
+  // and queued frames then go through the bus, whose transfer-complete ISR calls
+  // bus.OnTransferDone() in place of OnTransferDone(). A queued frame is taken from the
+  // draw buffer when the bus starts it, so drawing may go on while it waits, between
+  // BeginFrame() and EndFrame(): the bus leaves the display queued meanwhile, and
+  // queuing again before the start sends both frames as one. Present must not move once
+  // attached.
+  LibXR::ErrorCode AttachBus(BusSchedulerBase& bus, uint8_t priority = 0) noexcept
+  {
+    if (!initialized_)
+    {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (!caps_.async_present || kBuffers == 1)
+    {
+      return LibXR::ErrorCode::NOT_SUPPORT;
+    }
+    if (cfg_.buffer_mode == BufferMode::PAGE || bus_ != nullptr)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    const BusSlot SLOT =
+        bus.Attach(BusClient{this, &Present::StartOnBus, &Present::DoneOnBus, priority});
+    if (SLOT == INVALID_BUS_SLOT)
+    {
+      return LibXR::ErrorCode::SIZE_ERR;
+    }
+    bus_ = &bus;
+    bus_slot_ = SLOT;
+    return LibXR::ErrorCode::OK;
+  }
+
+  // With a list attached, BeginFrame() starts recording into it and EndFrame() culls
+  // and rasterizes it; draw through the list in between. nullptr detaches.
+  void AttachDrawList(DrawListBase* list) noexcept { draw_list_ = list; }
+
+  // Binds the planes of gray to the panel for PresentGrayPhase(). Draw into the planes
+  // only: each phase overwrites the draw surface where it changes. Needs Full mode, and
+  // SetFullRedrawHint() must stay off, as phases only send their changes. nullptr
+  // detaches.
+  LibXR::ErrorCode AttachGray(GraySurfaceBase* gray) noexcept
+  {
+    if (!initialized_)
+    {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (gray == nullptr)
+    {
+      gray_ = nullptr;
+      return LibXR::ErrorCode::OK;
+    }
+    if (cfg_.buffer_mode == BufferMode::PAGE)
     {
       return LibXR::ErrorCode::STATE_ERR;
     }
+    if (!gray->Bind(Size{cfg_.width, cfg_.height}, StrideBytes(cfg_), cfg_.layout,
+                    cfg_.rotation))
+    {
+      return LibXR::ErrorCode::SIZE_ERR;
+    }
+    gray_ = gray;
     return LibXR::ErrorCode::OK;
   }
 
+  // Presents the next phase of the attached gray planes as a DIFF frame, so only pixels
+  // that change on the panel are sent. Call it at a fixed rate the transfers keep up
+  // with (a timer, or the frame-done callback for back-to-back frames): the levels hold
+  // only while every phase is shown for the same time. With async_present it queues as
+  // QueueFrame() does. A phase that cannot go out returns BUSY and is presented by the
+  // next call instead.
+  LibXR::ErrorCode PresentGrayPhase() noexcept
+  {
+    if (!initialized_)
+    {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (gray_ == nullptr)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    if (frame_pending_.load() && bus_ == nullptr)
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
+    // Held like a frame being drawn, so a bus does not start this display mid-copy.
+    if (in_frame_.exchange(true))
+    {
+      return LibXR::ErrorCode::BUSY;
+    }
+    DirtyRegion region{};
+    const uint8_t* plane = gray_->StageNextPhase(region);
+    for (uint8_t i = 0; i < region.Count(); ++i)
+    {
+      CopyRegionFromPlane(plane, region.Rects()[i]);
+      surface_.AddDirtyRect(region.Rects()[i]);
+    }
+    in_frame_.store(false);
+
+    const LibXR::ErrorCode STATUS = QueueFrame(PresentMode::DIFF);
+    if (STATUS == LibXR::ErrorCode::OK)
+    {
+      gray_->AdvancePhase();
+    }
+    return STATUS;
+  }
+
   LibXR::ErrorCode BeginFrame() noexcept
   {
     if (!initialized_)
@@ -113,6 +300,11 @@ class Present
       return LibXR::ErrorCode::BUSY;
     }
     in_frame_ = true;
+    GetStats().OnDrawBegin();
+    if (draw_list_ != nullptr)
+    {
+      draw_list_->Begin(surface_);
+    }
     return LibXR::ErrorCode::OK;
   }
 
@@ -126,42 +318,138 @@ class Present
     {
       return LibXR::ErrorCode::ARG_ERR;
     }
+    if (draw_list_ != nullptr)
+    {
+      draw_list_->End();
+    }
     in_frame_ = false;
+    GetStats().OnDrawEnd();
+    if (bus_ != nullptr && frame_pending_.load())
+    {
+      bus_->Kick();
+    }
     return LibXR::ErrorCode::OK;
   }
 
+  // With three buffers a present during a transfer goes to the mailbox instead of
+  // returning BUSY. On a bus this is QueueFrame().
   LibXR::ErrorCode PresentFrame(PresentMode mode = PresentMode::AUTO) noexcept
   {
     if (!initialized_)
     {
       return LibXR::ErrorCode::INIT_ERR;
     }
+    if (bus_ != nullptr)
+    {
+      return QueueOnBus(mode);
+    }
+    if (cfg_.buffer_mode == BufferMode::PAGE)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    if (frame_pending_.load())
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
 
-    PresentMode resolved = mode;
-    if (!caps_.partial_update &&
-        (resolved == PresentMode::AUTO || resolved == PresentMode::DIRTY))
+    DirtyRegion region{};
+    const PageDirtyMap* pages = nullptr;
+    const PresentMode RESOLVED = ResolveFrame(mode, region, pages);
+    if (region.Empty())
     {
-      resolved = PresentMode::FULL;
+      DropUnchangedDiff(mode);
+      return LibXR::ErrorCode::OK;
     }
 
-    Rect region{};
-    if (resolved == PresentMode::FULL ||
-        (resolved == PresentMode::AUTO && !cfg_.enable_dirty_tracking))
+    return SubmitFrame(region, RESOLVED, pages);
+  }
+
+  // Like PresentFrame(), but while a transfer runs the frame is latched instead of
+  // rejected with BUSY and OnTransferDone() starts it. Returns BUSY only when a frame is
+  // already pending. Without async_present, or with one or three buffers, this is
+  // PresentFrame().
+  // The latched frame's buffer swap then runs in the ISR, with the copy of its region
+  // into the next draw buffer: up to a whole framebuffer, 1 KiB at 128x64. Where that
+  // is too long for the ISR, three buffers copy when presenting instead.
+  LibXR::ErrorCode QueueFrame(PresentMode mode = PresentMode::AUTO) noexcept
+  {
+    if (!initialized_)
     {
-      resolved = PresentMode::FULL;
-      region = FullRect(cfg_);
+      return LibXR::ErrorCode::INIT_ERR;
     }
-    else
+    if (!caps_.async_present || kBuffers != 2)
     {
-      region = ClipToFrame(surface_.GetDirtyRect(), cfg_);
-      if (rect_empty(region))
-      {
-        return LibXR::ErrorCode::OK;
-      }
-      resolved = PresentMode::DIRTY;
+      return PresentFrame(mode);
+    }
+    if (bus_ != nullptr)
+    {
+      return QueueOnBus(mode);
+    }
+    if (cfg_.buffer_mode == BufferMode::PAGE)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    if (frame_pending_.load())
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
     }
 
-    return SubmitFrame(region, resolved);
+    pending_mode_ = ResolveFrame(mode, pending_region_, pending_pages_);
+    if (pending_region_.Empty())
+    {
+      DropUnchangedDiff(mode);
+      return LibXR::ErrorCode::OK;
+    }
+    frame_pending_.store(true);
+
+    // The transfer may have completed before the latch became visible to the ISR; if
+    // so, take the frame back and start it here.
+    bool pending = true;
+    if (!transfer_in_progress_.load() &&
+        frame_pending_.compare_exchange_strong(pending, false))
+    {
+      return SubmitFrame(pending_region_, pending_mode_, pending_pages_);
+    }
+    return LibXR::ErrorCode::OK;
+  }
+
+  // Page mode frame loop: draw(surface) runs once per band of cfg.page_rows rows, with
+  // the surface bound to a cleared band buffer and clipped to it. Every band is sent to
+  // the backend as a partial FrameView, so the callback must redraw the whole frame.
+  template <typename DrawFn>
+  LibXR::ErrorCode PresentPages(DrawFn&& draw) noexcept
+  {
+    const LibXR::ErrorCode STATUS = CheckPagesReady();
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      return STATUS;
+    }
+    return PresentBands([&]() { draw(surface_); });
+  }
+
+  // Page mode frame loop that runs record(list) once instead of once per band. The
+  // calls are recorded over the whole frame, culled, and each band replays only those
+  // whose bounds meet it. If the list fills up, record(list) runs again for every band
+  // and draws straight into it, as PresentPages(draw) does.
+  template <typename RecordFn>
+  LibXR::ErrorCode PresentPages(DrawListBase& list, RecordFn&& record) noexcept
+  {
+    const LibXR::ErrorCode STATUS = CheckPagesReady();
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      return STATUS;
+    }
+
+    list.BeginBinned(surface_);
+    record(list);
+    list.End();
+    if (list.Overflowed())
+    {
+      return PresentBands([&]() { record(list); });
+    }
+    return PresentBands([&]() { list.ReplayBand(surface_); });
   }
 
   LibXR::ErrorCode PresentFrame(Rect dirty_rect) noexcept
@@ -170,19 +458,36 @@ class Present
     {
       return LibXR::ErrorCode::INIT_ERR;
     }
+    if (cfg_.buffer_mode == BufferMode::PAGE)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
 
     Rect clipped_dirty = ClipToFrame(dirty_rect, cfg_);
     if (rect_empty(clipped_dirty))
     {
       return LibXR::ErrorCode::ARG_ERR;
     }
+    if (bus_ != nullptr)
+    {
+      surface_.AddDirtyRect(clipped_dirty);
+      return QueueOnBus(PresentMode::DIRTY);
+    }
 
     PresentMode mode = caps_.partial_update ? PresentMode::DIRTY : PresentMode::FULL;
     if (mode == PresentMode::FULL)
     {
       clipped_dirty = FullRect(cfg_);
     }
-    return SubmitFrame(clipped_dirty, mode);
+    DirtyRegion region{};
+    region.Add(clipped_dirty);
+    PageDirtyMap pages{};
+    if (mode == PresentMode::DIRTY && surface_.IsPageDirtyEnabled())
+    {
+      pages.Add(clipped_dirty);
+      return SubmitFrame(region, mode, &pages);
+    }
+    return SubmitFrame(region, mode, nullptr);
   }
 
   LibXR::ErrorCode SetRotation(Rotation rotation) noexcept
@@ -192,10 +497,107 @@ class Present
       return LibXR::ErrorCode::INIT_ERR;
     }
     cfg_.rotation = rotation;
+    surface_.SetRotation(rotation);
+    if (gray_ != nullptr)
+    {
+      gray_->SetRotation(rotation);
+    }
     surface_.AddDirtyRect(FullRect(cfg_));
     return LibXR::ErrorCode::OK;
   }
 
+  // Scrolls the whole frame by dy rows (down when positive) and fills the uncovered rows
+  // with fill. With caps.hw_scroll and a rotation that keeps rows on panel rows the
+  // controller moves the image, so the next present only sends the uncovered strip and
+  // what was drawn; otherwise the buffer is moved and the whole frame is dirty.
+  // Attached gray planes scroll through their own surfaces instead.
+  LibXR::ErrorCode ScrollFrame(int16_t dy, Color fill = Color::BLACK) noexcept
+  {
+    if (!initialized_)
+    {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (cfg_.buffer_mode == BufferMode::PAGE || gray_ != nullptr)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    if (frame_pending_.load() && bus_ == nullptr)
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
+    if (dy == 0)
+    {
+      return LibXR::ErrorCode::OK;
+    }
+
+    const bool ALONG_ROWS =
+        cfg_.rotation == Rotation::R0 || cfg_.rotation == Rotation::R180;
+    // Scroll commands would cut into other displays' transfers on a shared bus.
+    if (!BackendHasScroll<Backend>::value || !caps_.hw_scroll || !ALONG_ROWS ||
+        bus_ != nullptr || std::abs(dy) >= cfg_.height)
+    {
+      ScrollSurface(surface_, dy, fill);
+      return LibXR::ErrorCode::OK;
+    }
+
+    // The controller must not move RAM under a running transfer.
+    if (IsTransferInProgress())
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
+    const int16_t ROWS =
+        (cfg_.rotation == Rotation::R180) ? static_cast<int16_t>(-dy) : dy;
+    const LibXR::ErrorCode STATUS = ScrollBackend(ROWS);
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      return STATUS;
+    }
+
+    // Pending damage moves with the image; the strip shows whatever wrapped around.
+    const DirtyRegion DRAWN = surface_.GetDirtyRegion();
+    ScrollSurface(surface_, dy, fill);
+    surface_.ClearDirtyRect();
+    for (uint8_t i = 0; i < DRAWN.Count(); ++i)
+    {
+      surface_.AddDirtyRect(offset_rect(DRAWN.Rects()[i], 0, ROWS));
+    }
+    const uint16_t STRIP_ROWS = static_cast<uint16_t>(std::abs(ROWS));
+    const Rect STRIP{
+        0,
+        static_cast<int16_t>(ROWS > 0 ? 0 : cfg_.height - STRIP_ROWS),
+        cfg_.width,
+        STRIP_ROWS,
+    };
+    surface_.AddDirtyRect(STRIP);
+
+    // The other buffers follow what the panel shows except in the strips, which DIFF
+    // must send whatever they compare like.
+    for (auto& stale : stale_)
+    {
+      MoveRegion(stale, ROWS);
+    }
+    MoveRegion(scrolled_, ROWS);
+    scrolled_.Add(STRIP);
+    for (uint8_t i = 0; i < kBuffers && (caps_.async_present || diff_enabled_); ++i)
+    {
+      if (i == draw_buffer_index_)
+      {
+        continue;
+      }
+      Surface back{};
+      back.Bind(framebuffers_[i].data(), Size{cfg_.width, cfg_.height}, StrideBytes(cfg_),
+                cfg_.layout);
+      ScrollSurface(back, ROWS, fill);
+    }
+    return LibXR::ErrorCode::OK;
+  }
+
+  // Promise that every frame after an async submit repaints the whole screen (e.g.
+  // starts with Clear()). The back buffer is then left stale instead of being synced.
+  void SetFullRedrawHint(bool full_redraw) noexcept { full_redraw_hint_ = full_redraw; }
+
   LibXR::ErrorCode SetPowerSave(bool enable) noexcept
   {
     if (!initialized_)
@@ -240,19 +642,231 @@ class Present
 
   static uint16_t StrideBytes(const DisplayConfig& cfg) noexcept
   {
-    return static_cast<uint16_t>((cfg.width + 7U) / 8U);
+    return layout_default_stride(cfg.width, cfg.layout);
+  }
+
+  static uint16_t PageCount(const DisplayConfig& cfg) noexcept
+  {
+    return static_cast<uint16_t>((cfg.height + PageDirtyMap::PAGE_ROWS - 1U) /
+                                 PageDirtyMap::PAGE_ROWS);
   }
 
+  static uint16_t BufferRows(const DisplayConfig& cfg) noexcept
+  {
+    if (cfg.buffer_mode == BufferMode::PAGE)
+    {
+      return std::min<uint16_t>(cfg.page_rows, cfg.height);
+    }
+    return cfg.height;
+  }
+
+  // Bytes of one draw buffer: the whole frame, or a single band in Page mode.
   static std::size_t FramebufferBytes(const DisplayConfig& cfg) noexcept
   {
     return static_cast<std::size_t>(StrideBytes(cfg)) *
-           static_cast<std::size_t>(cfg.height);
+           static_cast<std::size_t>(layout_line_count(BufferRows(cfg), cfg.layout));
+  }
+
+  // Fills region with what a present in mode has to send; leaves it empty when a dirty
+  // present has nothing to do.
+  PresentMode ResolveFrame(PresentMode mode, DirtyRegion& region,
+                           const PageDirtyMap*& pages) noexcept
+  {
+    region.Clear();
+    pages = nullptr;
+
+    PresentMode resolved = mode;
+    if (!caps_.partial_update && resolved != PresentMode::FULL)
+    {
+      resolved = PresentMode::FULL;
+    }
+    if (resolved == PresentMode::DIFF && kBuffers == 1)
+    {
+      // No buffer to hold the previous frame.
+      resolved = PresentMode::AUTO;
+    }
+    if (resolved == PresentMode::DIFF)
+    {
+      diff_enabled_ = true;
+      if (!diff_reference_valid_)
+      {
+        resolved = PresentMode::FULL;
+      }
+    }
+
+    if (resolved == PresentMode::DIFF)
+    {
+      // Only drawn areas can differ from the previous frame.
+      const bool PAGES = surface_.IsPageDirtyEnabled();
+      const DirtyRegion& drawn = surface_.GetDirtyRegion();
+      diff_pages_.Clear();
+      for (uint8_t i = 0; i < drawn.Count(); ++i)
+      {
+        diff_frames(framebuffers_[draw_buffer_index_].data(),
+                    framebuffers_[reference_buffer_].data(),
+                    Size{cfg_.width, cfg_.height}, StrideBytes(cfg_), cfg_.layout,
+                    drawn.Rects()[i], region, PAGES ? &diff_pages_ : nullptr);
+      }
+      for (uint8_t i = 0; i < scrolled_.Count(); ++i)
+      {
+        region.Add(scrolled_.Rects()[i]);
+        if (PAGES)
+        {
+          diff_pages_.Add(scrolled_.Rects()[i]);
+        }
+      }
+      pages = PAGES ? &diff_pages_ : nullptr;
+      return PresentMode::DIRTY;
+    }
+
+    if (resolved == PresentMode::FULL ||
+        (resolved == PresentMode::AUTO && !cfg_.enable_dirty_tracking))
+    {
+      region.Add(FullRect(cfg_));
+      return PresentMode::FULL;
+    }
+
+    region = surface_.GetDirtyRegion();
+    if (surface_.IsPageDirtyEnabled())
+    {
+      pages = &surface_.GetPageDirty();
+    }
+    return PresentMode::DIRTY;
+  }
+
+  // A diff that found no change still consumes the dirty region it scanned.
+  void DropUnchangedDiff(PresentMode mode) noexcept
+  {
+    if (mode == PresentMode::DIFF && diff_reference_valid_)
+    {
+      surface_.ClearDirtyRect();
+    }
+  }
+
+  static LibXR::ErrorCode StartOnBus(void* context)
+  {
+    return static_cast<Present*>(context)->StartBusFrame();
+  }
+
+  // A chunked frame keeps the bus until its last chunk.
+  static LibXR::ErrorCode DoneOnBus(void* context)
+  {
+    Present& self = *static_cast<Present*>(context);
+    const LibXR::ErrorCode STATUS = self.OnTransferDone();
+    return (STATUS == LibXR::ErrorCode::OK && self.IsTransferInProgress())
+               ? LibXR::ErrorCode::BUSY
+               : STATUS;
+  }
+
+  // The mode is stored before the latch, so a start that sees the latch sees the mode;
+  // a FULL request that just misses a start goes out with the next frame. The draw state
+  // is held meanwhile so the ISR does not start this display mid-update.
+  LibXR::ErrorCode QueueOnBus(PresentMode mode) noexcept
+  {
+    const bool DRAWING = in_frame_.exchange(true);
+    if (mode == PresentMode::FULL)
+    {
+      bus_full_.store(true);
+    }
+    else
+    {
+      bus_mode_.store(mode);
+    }
+    frame_pending_.store(true);
+    const uint32_t BYTES = EstimateBytes(mode);
+    in_frame_.store(DRAWING);
+    bus_->Request(bus_slot_, BYTES);
+    return LibXR::ErrorCode::OK;
+  }
+
+  // BusClient::start: resolves the queued frame from the draw buffer as it is now.
+  LibXR::ErrorCode StartBusFrame() noexcept
+  {
+    if (in_frame_.load())
+    {
+      return LibXR::ErrorCode::BUSY;
+    }
+    if (!frame_pending_.exchange(false))
+    {
+      return LibXR::ErrorCode::EMPTY;
+    }
+    const PresentMode MODE =
+        bus_full_.exchange(false) ? PresentMode::FULL : bus_mode_.load();
+    DirtyRegion region{};
+    const PageDirtyMap* pages = nullptr;
+    const PresentMode RESOLVED = ResolveFrame(MODE, region, pages);
+    if (region.Empty())
+    {
+      DropUnchangedDiff(MODE);
+      return LibXR::ErrorCode::EMPTY;
+    }
+    const LibXR::ErrorCode STATUS = SubmitFrame(region, RESOLVED, pages);
+    if (STATUS == LibXR::ErrorCode::BUSY)
+    {
+      bus_full_.store(bus_full_.load() || MODE == PresentMode::FULL);
+      frame_pending_.store(true);
+    }
+    return STATUS;
+  }
+
+  // Bus bytes of a present in mode, for the scheduler's ordering.
+  uint32_t EstimateBytes(PresentMode mode) const noexcept
+  {
+    if (mode == PresentMode::FULL || !caps_.partial_update ||
+        (mode == PresentMode::AUTO && !cfg_.enable_dirty_tracking))
+    {
+      return static_cast<uint32_t>(FramebufferBytes(cfg_));
+    }
+    uint32_t bytes = 0;
+    const DirtyRegion& drawn = surface_.GetDirtyRegion();
+    for (uint8_t i = 0; i < drawn.Count(); ++i)
+    {
+      const ByteWindow WINDOW = layout_byte_window(drawn.Rects()[i], cfg_.layout);
+      bytes += static_cast<uint32_t>(WINDOW.byte_end - WINDOW.byte_begin) *
+               static_cast<uint32_t>(WINDOW.line_end - WINDOW.line_begin);
+    }
+    return bytes;
+  }
+
+  // Moves the rects of region down by rows panel rows, dropping what leaves the frame.
+  void MoveRegion(DirtyRegion& region, int16_t rows) const noexcept
+  {
+    const DirtyRegion MOVED = region;
+    region.Clear();
+    for (uint8_t i = 0; i < MOVED.Count(); ++i)
+    {
+      region.Add(ClipToFrame(offset_rect(MOVED.Rects()[i], 0, rows), cfg_));
+    }
+  }
+
+  LibXR::ErrorCode ScrollBackend(int16_t rows) noexcept
+  {
+    if constexpr (BackendHasScroll<Backend>::value)
+    {
+      return backend_.Scroll(rows);
+    }
+    else
+    {
+      UNUSED(rows);
+      return LibXR::ErrorCode::NOT_SUPPORT;
+    }
+  }
+
+  // Scrolls everything bound to surface, whatever its clip.
+  static void ScrollSurface(Surface& surface, int16_t dy, Color fill) noexcept
+  {
+    const Rect CLIP = surface.GetClip();
+    const Size SIZE = surface.GetSize();
+    surface.ResetClip();
+    surface.ScrollRect(Rect{0, 0, SIZE.w, SIZE.h}, 0, dy, fill);
+    surface.SetClip(CLIP);
   }
 
-  void BindDrawSurface() noexcept
+  void BindDrawSurface(uint16_t first_row = 0) noexcept
   {
-    surface_.Bind(framebuffers_[draw_buffer_index_].data(), Size{cfg_.width, cfg_.height},
-                  StrideBytes(cfg_));
+    surface_.BindBand(framebuffers_[draw_buffer_index_].data(),
+                      Size{cfg_.width, cfg_.height}, first_row, BufferRows(cfg_),
+                      StrideBytes(cfg_), cfg_.layout);
   }
 
   void ClearAllBuffers() noexcept
@@ -274,84 +888,494 @@ class Present
     }
 
     const uint16_t STRIDE = StrideBytes(cfg_);
-    const int32_t X_BYTE_START = static_cast<int32_t>(CLIPPED.x) / 8;
-    const int32_t X_BYTE_END =
-        (static_cast<int32_t>(CLIPPED.x) + static_cast<int32_t>(CLIPPED.w) + 7) / 8;
-    const std::size_t COPY_BYTES = static_cast<std::size_t>(X_BYTE_END - X_BYTE_START);
-    if (COPY_BYTES == 0U)
+    const ByteWindow WINDOW = layout_byte_window(CLIPPED, cfg_.layout);
+    const std::size_t COPY_BYTES =
+        static_cast<std::size_t>(WINDOW.byte_end - WINDOW.byte_begin);
+    for (uint16_t line = WINDOW.line_begin; line < WINDOW.line_end; ++line)
+    {
+      const std::size_t LINE_OFFSET = static_cast<std::size_t>(line) * STRIDE +
+                                      static_cast<std::size_t>(WINDOW.byte_begin);
+      std::copy_n(framebuffers_[src_index].begin() + LINE_OFFSET, COPY_BYTES,
+                  framebuffers_[dst_index].begin() + LINE_OFFSET);
+    }
+    GetStats().OnBufferCopy(COPY_BYTES * (WINDOW.line_end - WINDOW.line_begin));
+  }
+
+  // Copies region of a gray plane, which has the framebuffer geometry, into the draw
+  // buffer.
+  void CopyRegionFromPlane(const uint8_t* plane, Rect region) noexcept
+  {
+    const Rect CLIPPED = ClipToFrame(region, cfg_);
+    if (rect_empty(CLIPPED))
     {
       return;
     }
 
-    const int32_t Y_START = static_cast<int32_t>(CLIPPED.y);
-    const int32_t Y_END =
-        static_cast<int32_t>(CLIPPED.y) + static_cast<int32_t>(CLIPPED.h);
-    for (int32_t y = Y_START; y < Y_END; ++y)
+    const uint16_t STRIDE = StrideBytes(cfg_);
+    const ByteWindow WINDOW = layout_byte_window(CLIPPED, cfg_.layout);
+    const std::size_t COPY_BYTES =
+        static_cast<std::size_t>(WINDOW.byte_end - WINDOW.byte_begin);
+    for (uint16_t line = WINDOW.line_begin; line < WINDOW.line_end; ++line)
     {
-      const std::size_t ROW_OFFSET =
-          static_cast<std::size_t>(y) * STRIDE + static_cast<std::size_t>(X_BYTE_START);
-      std::copy_n(framebuffers_[src_index].begin() + ROW_OFFSET, COPY_BYTES,
-                  framebuffers_[dst_index].begin() + ROW_OFFSET);
+      const std::size_t LINE_OFFSET = static_cast<std::size_t>(line) * STRIDE +
+                                      static_cast<std::size_t>(WINDOW.byte_begin);
+      std::copy_n(plane + LINE_OFFSET, COPY_BYTES,
+                  framebuffers_[draw_buffer_index_].begin() + LINE_OFFSET);
     }
+    GetStats().OnBufferCopy(COPY_BYTES * (WINDOW.line_end - WINDOW.line_begin));
   }
 
-  void SwapToNextDrawBuffer(Rect sync_region) noexcept
+  // Drawing moves to a buffer other than the submitted one and busy, which lags the
+  // submitted one by what was drawn since it was last current. Only that damage is
+  // copied; FULL submits do not imply a full copy.
+  void SwapToNextDrawBuffer(const DirtyRegion& submitted, PresentMode mode,
+                            uint8_t busy) noexcept
   {
     const uint8_t SUBMITTED = draw_buffer_index_;
-    const uint8_t NEXT = static_cast<uint8_t>(SUBMITTED ^ 1U);
-    CopyRegionBetweenBuffers(SUBMITTED, NEXT, sync_region);
-    draw_buffer_index_ = NEXT;
+    uint8_t next = 0;
+    while (next == SUBMITTED || next == busy)
+    {
+      ++next;
+    }
+
+    const DirtyRegion& drawn = surface_.GetDirtyRegion();
+    for (uint8_t buffer = 0; buffer < kBuffers; ++buffer)
+    {
+      if (buffer == SUBMITTED)
+      {
+        continue;
+      }
+      DirtyRegion& stale = stale_[buffer];
+      for (uint8_t i = 0; i < drawn.Count(); ++i)
+      {
+        stale.Add(drawn.Rects()[i]);
+      }
+      if (mode != PresentMode::FULL)
+      {
+        // PresentFrame(Rect) may name pixels the surface did not track.
+        for (uint8_t i = 0; i < submitted.Count(); ++i)
+        {
+          stale.Add(submitted.Rects()[i]);
+        }
+      }
+    }
+    stale_[SUBMITTED].Clear();
+
+    if (!full_redraw_hint_)
+    {
+      DirtyRegion& stale = stale_[next];
+      for (uint8_t i = 0; i < stale.Count(); ++i)
+      {
+        CopyRegionBetweenBuffers(SUBMITTED, next, stale.Rects()[i]);
+      }
+      stale.Clear();
+    }
+    reference_buffer_ = SUBMITTED;
+    draw_buffer_index_ = next;
     BindDrawSurface();
     surface_.ClearDirtyRect();
   }
 
-  LibXR::ErrorCode SubmitFrame(Rect region, PresentMode mode) noexcept
+  // Without async_present the second buffer is idle; once DIFF is used it shadows what
+  // the panel shows. It becomes a valid reference after the first full present.
+  // Single-buffered presents have no shadow, as DIFF is never enabled.
+  void UpdateDiffShadow(const DirtyRegion& sent, PresentMode mode) noexcept
+  {
+    if (!diff_enabled_ || (!diff_reference_valid_ && mode != PresentMode::FULL))
+    {
+      return;
+    }
+    for (uint8_t i = 0; i < sent.Count(); ++i)
+    {
+      CopyRegionBetweenBuffers(draw_buffer_index_, reference_buffer_, sent.Rects()[i]);
+    }
+    diff_reference_valid_ = true;
+  }
+
+  LibXR::ErrorCode SubmitFrame(const DirtyRegion& region, PresentMode mode,
+                               const PageDirtyMap* pages) noexcept
+  {
+    GetStats().OnSubmitBegin();
+    const LibXR::ErrorCode STATUS = SendFrame(region, mode, pages);
+    GetStats().OnSubmitEnd(STATUS);
+    return STATUS;
+  }
+
+  LibXR::ErrorCode SendFrame(const DirtyRegion& region, PresentMode mode,
+                             const PageDirtyMap* pages) noexcept
+  {
+    DirtyRegion windows{};
+    if (!caps_.async_present || kBuffers == 1)
+    {
+      // Without a second buffer the transfer has to finish before drawing goes on.
+      if (caps_.async_present)
+      {
+        BeginTransfer();
+      }
+      const LibXR::ErrorCode STATUS =
+          PresentBuffer(draw_buffer_index_, region, mode, pages, windows);
+      if (STATUS != LibXR::ErrorCode::OK)
+      {
+        transfer_in_progress_.store(false, std::memory_order_release);
+        return STATUS;
+      }
+      if (caps_.async_present)
+      {
+        WaitForTransfer();
+      }
+      UpdateDiffShadow(windows, mode);
+      surface_.ClearDirtyRect();
+      scrolled_.Clear();
+      return LibXR::ErrorCode::OK;
+    }
+
+    if (transfer_in_progress_.load(std::memory_order_acquire))
+    {
+      if (kBuffers >= 3)
+      {
+        return PostToMailbox(region, mode, pages);
+      }
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
+
+    const uint8_t PREVIOUS_FRONT = front_buffer_;
+    front_buffer_ = draw_buffer_index_;
+    BeginTransfer();
+    const LibXR::ErrorCode STATUS =
+        PresentBuffer(draw_buffer_index_, region, mode, pages, windows);
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      transfer_in_progress_.store(false, std::memory_order_release);
+      front_buffer_ = PREVIOUS_FRONT;
+      return STATUS;
+    }
+
+    CommitSubmit(region, mode, front_buffer_);
+    return LibXR::ErrorCode::OK;
+  }
+
+  // Presents region of buffer. Backends that take fewer windows get a coarser copy,
+  // left in windows; buffer sync keeps the finer region.
+  LibXR::ErrorCode PresentBuffer(uint8_t buffer, const DirtyRegion& region,
+                                 PresentMode mode, const PageDirtyMap* pages,
+                                 DirtyRegion& windows) noexcept
   {
+    windows = region;
+    windows.ReduceTo(caps_.max_dirty_rects);
+    const uint8_t PAGE_COUNT = (pages != nullptr) ? static_cast<uint8_t>(PageCount(cfg_))
+                                                  : static_cast<uint8_t>(0);
+
     FrameView frame{
-        framebuffers_[draw_buffer_index_].data(),
+        framebuffers_[buffer].data(),
         cfg_.width,
         cfg_.height,
         StrideBytes(cfg_),
-        region,
+        windows.Bounds(),
+        0,
+        cfg_.height,
+        windows.Rects(),
+        windows.Count(),
+        (pages != nullptr) ? pages->Spans() : nullptr,
+        PAGE_COUNT,
+        cfg_.layout,
     };
 
-    if (!caps_.async_present)
+    uint32_t pixels = 0;
+    for (uint8_t i = 0; i < windows.Count(); ++i)
+    {
+      pixels += static_cast<uint32_t>(windows.Rects()[i].w) * windows.Rects()[i].h;
+    }
+    GetStats().OnDirtyPixels(pixels);
+    return PresentView(frame, mode);
+  }
+
+  // The draw buffer now holds a frame that is sent or on its way; drawing moves on to a
+  // buffer other than it and busy.
+  void CommitSubmit(const DirtyRegion& region, PresentMode mode, uint8_t busy) noexcept
+  {
+    scrolled_.Clear();
+    // The submitted buffer becomes the reference for DIFF.
+    diff_reference_valid_ = diff_reference_valid_ || mode == PresentMode::FULL;
+    SwapToNextDrawBuffer(region, mode, busy);
+  }
+
+  // Three buffers: the draw buffer becomes the mailbox and drawing moves to the free
+  // buffer. A frame still waiting in the mailbox is dropped, and the new one takes over
+  // its region too, since the panel has not shown it.
+  LibXR::ErrorCode PostToMailbox(const DirtyRegion& region, PresentMode mode,
+                                 const PageDirtyMap* pages) noexcept
+  {
+    // Emptying the mailbox first keeps the ISR off it and off front_buffer_.
+    if (mailbox_full_.exchange(false, std::memory_order_acq_rel))
     {
-      const LibXR::ErrorCode STATUS = backend_.Present(frame, mode);
-      if (STATUS == LibXR::ErrorCode::OK)
+      for (uint8_t i = 0; i < region.Count(); ++i)
       {
-        surface_.ClearDirtyRect();
+        pending_region_.Add(region.Rects()[i]);
+      }
+      const bool FULL = pending_mode_ == PresentMode::FULL || mode == PresentMode::FULL;
+      pending_mode_ = FULL ? PresentMode::FULL : PresentMode::DIRTY;
+      if (pending_pages_ != nullptr && pages != nullptr)
+      {
+        MergePages(mailbox_pages_, *pages);
+      }
+      else
+      {
+        pending_pages_ = nullptr;
       }
-      return STATUS;
     }
+    else
+    {
+      pending_region_ = region;
+      pending_mode_ = mode;
+      pending_pages_ = nullptr;
+      if (pages != nullptr)
+      {
+        mailbox_pages_ = *pages;
+        pending_pages_ = &mailbox_pages_;
+      }
+    }
+    mailbox_buffer_ = draw_buffer_index_;
+    CommitSubmit(region, mode, front_buffer_);
+    mailbox_full_.store(true, std::memory_order_release);
 
-    if (transfer_in_progress_.load(std::memory_order_acquire))
+    // The transfer may have completed before the mailbox was filled; start it here.
+    if (!transfer_in_progress_.load(std::memory_order_acquire) &&
+        mailbox_full_.exchange(false, std::memory_order_acq_rel))
     {
-      return LibXR::ErrorCode::BUSY;
+      return StartMailboxFrame();
     }
+    return LibXR::ErrorCode::OK;
+  }
 
-    const LibXR::ErrorCode STATUS = backend_.Present(frame, mode);
+  LibXR::ErrorCode StartMailboxFrame() noexcept
+  {
+    GetStats().OnSubmitBegin();
+    const uint8_t PREVIOUS_FRONT = front_buffer_;
+    front_buffer_ = mailbox_buffer_;
+    BeginTransfer();
+    DirtyRegion windows{};
+    const LibXR::ErrorCode STATUS =
+        PresentBuffer(mailbox_buffer_, pending_region_, pending_mode_, pending_pages_,
+                      windows);
     if (STATUS != LibXR::ErrorCode::OK)
     {
-      return STATUS;
+      transfer_in_progress_.store(false, std::memory_order_release);
+      front_buffer_ = PREVIOUS_FRONT;
+    }
+    GetStats().OnSubmitEnd(STATUS);
+    return STATUS;
+  }
+
+  static void MergePages(PageDirtyMap& into, const PageDirtyMap& from) noexcept
+  {
+    for (uint8_t page = 0; page < PageDirtyMap::MAX_PAGES; ++page)
+    {
+      const PageSpan SPAN = from.Spans()[page];
+      if (SPAN.x_end > SPAN.x_begin)
+      {
+        into.Add(Rect{static_cast<int16_t>(SPAN.x_begin),
+                      static_cast<int16_t>(page * PageDirtyMap::PAGE_ROWS),
+                      static_cast<uint16_t>(SPAN.x_end - SPAN.x_begin),
+                      PageDirtyMap::PAGE_ROWS});
+      }
     }
+  }
 
+  // Marks a transfer as running before the backend is asked to start it: the completion
+  // can fire, or the HAL call back, before the start call returns. Start sites clear the
+  // flag again when the start fails.
+  void BeginTransfer() noexcept
+  {
+    GetStats().OnTransferStart();
     transfer_in_progress_.store(true, std::memory_order_release);
-    SwapToNextDrawBuffer(region);
+  }
+
+  // Spins until OnTransferDone() ends the running transfer from its ISR.
+  void WaitForTransfer() const noexcept
+  {
+    while (transfer_in_progress_.load(std::memory_order_acquire))
+    {
+    }
+  }
+
+  // Hands frame to the backend, split into chunks when caps.max_chunk_bytes is set. An
+  // async frame starts with its first chunk and OnTransferDone() sends the rest; frame
+  // must then stay valid until the transfer completes, which it does for the buffer that
+  // was just submitted.
+  LibXR::ErrorCode PresentView(const FrameView& frame, PresentMode mode) noexcept
+  {
+    if (caps_.max_chunk_bytes == 0U)
+    {
+      return backend_.Present(frame, mode);
+    }
+    chunk_frame_ = frame;
+    chunks_.Start(frame.dirty_rects, frame.dirty_count, cfg_.layout,
+                  caps_.max_chunk_bytes);
+    LibXR::ErrorCode status = SendNextChunk();
+    while (!caps_.async_present && status == LibXR::ErrorCode::OK)
+    {
+      status = SendNextChunk();
+    }
+    if (status != LibXR::ErrorCode::OK && status != LibXR::ErrorCode::EMPTY)
+    {
+      chunks_.Clear();
+      return status;
+    }
     return LibXR::ErrorCode::OK;
   }
 
+  // EMPTY once the chunks of the current frame are used up, or when it was not chunked.
+  LibXR::ErrorCode SendNextChunk() noexcept
+  {
+    Rect chunk{};
+    if (!chunks_.Next(chunk))
+    {
+      return LibXR::ErrorCode::EMPTY;
+    }
+    FrameView view = chunk_frame_;
+    view.dirty = chunk;
+    view.dirty_rects = &chunk;
+    view.dirty_count = 1;
+    view.page_dirty = nullptr;
+    view.page_count = 0;
+    const LibXR::ErrorCode STATUS = backend_.Present(view, PresentMode::DIRTY);
+    chunk_frame_.continuation = true;
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      chunks_.Clear();
+    }
+    return STATUS;
+  }
+
+  LibXR::ErrorCode CheckPagesReady() noexcept
+  {
+    if (!initialized_)
+    {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (cfg_.buffer_mode != BufferMode::PAGE)
+    {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    if (!caps_.partial_update)
+    {
+      return LibXR::ErrorCode::NOT_SUPPORT;
+    }
+    if (in_frame_ || IsTransferInProgress())
+    {
+      GetStats().OnBusy();
+      return LibXR::ErrorCode::BUSY;
+    }
+    return LibXR::ErrorCode::OK;
+  }
+
+  // Binds, clears and sends each band in turn; draw_band() fills the bound band.
+  template <typename BandFn>
+  LibXR::ErrorCode PresentBands(BandFn&& draw_band) noexcept
+  {
+    for (uint16_t first_row = 0; first_row < cfg_.height; first_row += cfg_.page_rows)
+    {
+      BindDrawSurface(first_row);
+      surface_.Clear(Color::BLACK);
+      surface_.ClearDirtyRect();
+      draw_band();
+
+      const LibXR::ErrorCode STATUS = SubmitBand(surface_.GetBand());
+      if (STATUS != LibXR::ErrorCode::OK)
+      {
+        BindDrawSurface(0);
+        return STATUS;
+      }
+      if (caps_.async_present)
+      {
+        draw_buffer_index_ = static_cast<uint8_t>((draw_buffer_index_ + 1U) % kBuffers);
+      }
+    }
+    BindDrawSurface(0);
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode SubmitBand(Rect band) noexcept
+  {
+    FrameView frame{
+        framebuffers_[draw_buffer_index_].data(),
+        cfg_.width,
+        cfg_.height,
+        StrideBytes(cfg_),
+        band,
+        static_cast<uint16_t>(band.y),
+        band.h,
+        &band,
+        1,
+        nullptr,
+        0,
+        cfg_.layout,
+    };
+
+    if (caps_.async_present)
+    {
+      // One transfer at a time: the previous band was sent while this one was drawn.
+      // Once it completes its buffer is free for the next band.
+      WaitForTransfer();
+      BeginTransfer();
+    }
+    const LibXR::ErrorCode STATUS = PresentView(frame, PresentMode::DIRTY);
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      transfer_in_progress_.store(false, std::memory_order_release);
+    }
+    else if (caps_.async_present)
+    {
+      if (kBuffers == 1)
+      {
+        // The next band is drawn into this buffer.
+        WaitForTransfer();
+      }
+    }
+    return STATUS;
+  }
+
  private:
   DisplayConfig cfg_{};
   BackendCaps caps_{};
   Backend backend_;
   // Keep Present in static/global storage when framebuffer is large.
-  std::array<std::array<uint8_t, kFramebufferBytes>, 2> framebuffers_{};
+  // In Page mode each buffer only has to hold one band: stride * page_rows bytes.
+  std::array<std::array<uint8_t, kFramebufferBytes>, kBuffers> framebuffers_{};
   Surface surface_{};
   uint8_t draw_buffer_index_{0};
+  // Latest submitted frame, or the shadow of the panel without async_present.
+  uint8_t reference_buffer_{static_cast<uint8_t>(kBuffers > 1U ? 1U : 0U)};
+  uint8_t front_buffer_{0};  // Buffer of the running transfer.
+  // Damage each buffer is missing; left behind for the back buffer under the hint.
+  std::array<DirtyRegion, kBuffers> stale_{};
+  bool full_redraw_hint_{false};
+  bool diff_enabled_{false};
+  bool diff_reference_valid_{false};
+  PageDirtyMap diff_pages_{};  // Page spans of the last DIFF present.
+  DirtyRegion scrolled_{};     // Panel rows showing wrapped RAM after a hardware scroll.
+  FrameView chunk_frame_{};    // Frame whose chunks are being sent.
+  ChunkCursor chunks_{};
   std::atomic<bool> transfer_in_progress_{false};
+  std::atomic<bool> frame_pending_{false};
+  DirtyRegion pending_region_{};
+  PresentMode pending_mode_{PresentMode::FULL};
+  const PageDirtyMap* pending_pages_{nullptr};
+  // Three buffers: the frame that waits for the running transfer, in pending_*.
+  uint8_t mailbox_buffer_{0};
+  std::atomic<bool> mailbox_full_{false};
+  PageDirtyMap mailbox_pages_{};
+  FrameDoneCallback frame_done_callback_{nullptr};
+  void* frame_done_context_{nullptr};
+  DrawListBase* draw_list_{nullptr};
+  GraySurfaceBase* gray_{nullptr};
+  BusSchedulerBase* bus_{nullptr};
+  BusSlot bus_slot_{INVALID_BUS_SLOT};
+  std::atomic<PresentMode> bus_mode_{PresentMode::AUTO};  // Latest partial request.
+  std::atomic<bool> bus_full_{false};                     // A FULL request is queued.
   bool initialized_{false};
-  bool in_frame_{false};
+  std::atomic<bool> in_frame_{false};
 };
 
 }  // namespace MonoGL
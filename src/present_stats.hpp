@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libxr_def.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+// Stats policy for Present. Every hook is an empty inline call, so the default policy
+// generates no code. Transfer hooks run in OnTransferDone() (ISR) context.
+struct NullStats
+{
+  void OnDrawBegin() noexcept {}
+  void OnDrawEnd() noexcept {}
+  void OnSubmitBegin() noexcept {}
+  void OnSubmitEnd(LibXR::ErrorCode) noexcept {}
+  void OnDirtyPixels(uint32_t) noexcept {}
+  void OnBufferCopy(std::size_t) noexcept {}
+  void OnBusy() noexcept {}
+  void OnTransferStart() noexcept {}
+  void OnTransferDone() noexcept {}
+};
+
+// Figures of the most recent frame plus running totals. Ticks are in Clock units.
+struct FrameStats
+{
+  uint32_t draw_ticks{0};      // BeginFrame() to EndFrame().
+  uint32_t submit_ticks{0};    // Inside PresentFrame/QueueFrame/OnTransferDone submits.
+  uint32_t transfer_ticks{0};  // Backend::Present() accepted until OnTransferDone().
+  uint32_t copy_bytes{0};      // Bytes copied between draw buffers.
+  uint32_t dirty_pixels{0};    // Area of the windows handed to the backend.
+
+  uint32_t frames{0};            // Successful submits.
+  uint32_t busy_rejections{0};   // Calls that returned BUSY.
+  uint32_t max_submit_ticks{0};
+  uint32_t max_transfer_ticks{0};
+};
+
+// Records FrameStats using Clock, which provides static uint32_t Now() noexcept.
+// Differences are taken modulo 2^32, so a wrapping counter is fine.
+template <typename Clock>
+class ClockStats
+{
+ public:
+  void OnDrawBegin() noexcept { draw_start_ = Clock::Now(); }
+  void OnDrawEnd() noexcept { stats_.draw_ticks = Clock::Now() - draw_start_; }
+
+  void OnSubmitBegin() noexcept
+  {
+    submit_start_ = Clock::Now();
+    copy_bytes_ = 0;
+  }
+
+  void OnSubmitEnd(LibXR::ErrorCode status) noexcept
+  {
+    const uint32_t TICKS = Clock::Now() - submit_start_;
+    if (status != LibXR::ErrorCode::OK)
+    {
+      return;
+    }
+    stats_.submit_ticks = TICKS;
+    stats_.copy_bytes = copy_bytes_;
+    stats_.max_submit_ticks = (TICKS > stats_.max_submit_ticks) ? TICKS
+                                                                : stats_.max_submit_ticks;
+    ++stats_.frames;
+  }
+
+  void OnDirtyPixels(uint32_t pixels) noexcept { stats_.dirty_pixels = pixels; }
+  void OnBufferCopy(std::size_t bytes) noexcept
+  {
+    copy_bytes_ += static_cast<uint32_t>(bytes);
+  }
+  void OnBusy() noexcept { ++stats_.busy_rejections; }
+  void OnTransferStart() noexcept { transfer_start_ = Clock::Now(); }
+
+  void OnTransferDone() noexcept
+  {
+    const uint32_t TICKS = Clock::Now() - transfer_start_;
+    stats_.transfer_ticks = TICKS;
+    stats_.max_transfer_ticks = (TICKS > stats_.max_transfer_ticks)
+                                    ? TICKS
+                                    : stats_.max_transfer_ticks;
+  }
+
+  const FrameStats& Get() const noexcept { return stats_; }
+  void Reset() noexcept { stats_ = FrameStats{}; }
+
+ private:
+  FrameStats stats_{};
+  uint32_t draw_start_{0};
+  uint32_t submit_start_{0};
+  uint32_t transfer_start_{0};
+  uint32_t copy_bytes_{0};
+};
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+    defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+// Cortex-M DWT cycle counter. Call Enable() once before use; it may already be
+// running when a debugger is attached.
+struct DwtCycleClock
+{
+  static void Enable() noexcept
+  {
+    constexpr uint32_t TRCENA = 1UL << 24;
+    constexpr uint32_t CYCCNTENA = 1UL << 0;
+    *reinterpret_cast<volatile uint32_t*>(DEMCR_ADDR) |= TRCENA;
+    *reinterpret_cast<volatile uint32_t*>(DWT_CYCCNT_ADDR) = 0;
+    *reinterpret_cast<volatile uint32_t*>(DWT_CTRL_ADDR) |= CYCCNTENA;
+  }
+
+  static uint32_t Now() noexcept
+  {
+    return *reinterpret_cast<volatile uint32_t*>(DWT_CYCCNT_ADDR);
+  }
+
+  static constexpr uintptr_t DEMCR_ADDR = 0xE000EDFCUL;
+  static constexpr uintptr_t DWT_CTRL_ADDR = 0xE0001000UL;
+  static constexpr uintptr_t DWT_CYCCNT_ADDR = 0xE0001004UL;
+};
+#endif
+
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 
 #include "surface.hpp"
 
@@ -9,14 +11,6 @@ namespace LibXR
 namespace MonoGL
 {
 
-enum class Rotation : uint8_t
-{
-  R0,
-  R90,
-  R180,
-  R270
-};
-
 enum class BufferMode : uint8_t
 {
   FULL = 0,
@@ -27,26 +21,46 @@ enum class PresentMode : uint8_t
 {
   AUTO = 0,
   FULL = 1,
-  DIRTY = 2
+  DIRTY = 2,
+  // Sends what actually changed since the last present, found by comparing the draw
+  // buffer with the previous frame. Backends receive it as DIRTY.
+  DIFF = 3
 };
 
 struct DisplayConfig
 {
-  uint16_t width{0};
+  uint16_t width{0};   // Panel size; the Surface reports the rotated size.
   uint16_t height{0};
   Rotation rotation{Rotation::R0};
   BufferMode buffer_mode{BufferMode::FULL};
-  uint8_t page_rows{8};  // Valid in Page mode.
+  uint8_t page_rows{8};  // Valid in Page mode; a multiple of 8 for VERTICAL_PAGE.
+  PixelLayout layout{PixelLayout::ROW_MAJOR_MSB};  // Native layout of the controller.
   bool enable_dirty_tracking{true};
+  // Per 8-row page dirty column ranges in FrameView; needs height <= 128.
+  bool enable_page_dirty_tracking{false};
 };
 
 struct FrameView
 {
-  const uint8_t* bits{nullptr};  // 1bpp, row-major bit-packed.
+  const uint8_t* bits{nullptr};  // 1bpp, packed as described by layout.
   uint16_t width{0};
   uint16_t height{0};
   uint16_t stride_bytes{0};
-  Rect dirty{};
+  Rect dirty{};  // Bounding box of dirty_rects.
+  uint16_t row_begin{0};  // Frame row stored at bits[0]; non-zero for Page mode bands.
+  uint16_t row_count{0};  // Rows stored in bits; equals height in Full mode.
+  // Windows to transfer, at most caps.max_dirty_rects of them. Valid only during
+  // Backend::Present; backends that keep them for an async transfer must copy them.
+  const Rect* dirty_rects{nullptr};
+  uint8_t dirty_count{0};
+  // Dirty columns of each 8-row page (page_dirty[p] covers rows 8p..8p+7), same lifetime
+  // as dirty_rects. nullptr for full presents or when page tracking is disabled.
+  const PageSpan* page_dirty{nullptr};
+  uint8_t page_count{0};
+  // stride_bytes is bytes per line: per pixel row, or per 8-row page for VERTICAL_PAGE.
+  PixelLayout layout{PixelLayout::ROW_MAJOR_MSB};
+  // Set on every chunk but the first when caps.max_chunk_bytes splits a present.
+  bool continuation{false};
 };
 
 struct BackendCaps
@@ -55,6 +69,29 @@ struct BackendCaps
   bool power_save{false};
   bool contrast{false};
   bool async_present{false};
+  uint8_t max_dirty_rects{1};  // Windows a DIRTY present may carry; 0 is treated as 1.
+  // Backend::Scroll(rows) moves the whole panel image down by rows panel rows (up when
+  // negative), e.g. through the display start line of SSD1306/SH1106, and keeps mapping
+  // later frames onto the moved controller RAM.
+  bool hw_scroll{false};
+  // Largest framebuffer byte count one Backend::Present may carry; 0 for no limit. Any
+  // larger frame arrives as DIRTY presents of one window each (see ChunkCursor). Async
+  // backends get the next chunk from OnTransferDone(), and the frame completes with its
+  // last chunk. Needs partial_update.
+  uint16_t max_chunk_bytes{0};
+};
+
+// Backend::Scroll() is optional; without it caps.hw_scroll is ignored.
+template <typename Backend, typename = void>
+struct BackendHasScroll : std::false_type
+{
+};
+
+template <typename Backend>
+struct BackendHasScroll<
+    Backend, std::void_t<decltype(std::declval<Backend&>().Scroll(int16_t{}))>>
+    : std::true_type
+{
 };
 
 }  // namespace MonoGL
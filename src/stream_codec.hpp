@@ -0,0 +1,618 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "libxr_def.hpp"
+#include "present_types.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+// Frame stream format, little-endian:
+//   packet := MAGIC flags:u8 width:u16 height:u16 layout:u8 window_count:u8 window*
+//   window := line_begin:u16 line_count:u16 byte_begin:u16 byte_count:u16 rle
+// A window covers byte_count bytes of line_count lines, packed with the layout's default
+// stride. STREAM_KEY packets carry the pixels; other packets carry the XOR against the
+// previous frame. rle is a run of chunks until the window is filled:
+//   control < 0x80: control + 1 literal bytes follow
+//   control >= 0x80: the next byte repeats (control & 0x7F) + 1 times
+constexpr uint8_t STREAM_MAGIC = 0xA5;
+constexpr uint8_t STREAM_KEY = 0x01;
+
+// Backend adapter that forwards to Inner and mirrors every presented frame to Sink as
+// a compressed stream. Sink provides ErrorCode Write(const uint8_t*, std::size_t).
+// kFrameBytes must hold stride_bytes * lines of the whole frame, also in Page mode.
+template <typename Inner, typename Sink, std::size_t kFrameBytes>
+class StreamEncoderBackend
+{
+ public:
+  static_assert(kFrameBytes > 0, "kFrameBytes must be greater than 0.");
+
+  // keyframe_interval counts frames, not the chunks of a split present; 0 sends keys
+  // only at start and on request.
+  StreamEncoderBackend(Inner inner, Sink sink, uint16_t keyframe_interval = 30)
+      : inner_(std::move(inner)),
+        sink_(std::move(sink)),
+        keyframe_interval_(keyframe_interval)
+  {
+  }
+
+  LibXR::ErrorCode Init(const DisplayConfig& cfg) noexcept
+  {
+    previous_.fill(0U);
+    key_due_ = true;
+    key_active_ = false;
+    frames_since_key_ = 0;
+    return inner_.Init(cfg);
+  }
+
+  // A hardware scroll would move the panel under the stream, so the receiver would
+  // lose sync; ScrollFrame() moves the buffer instead and the move goes out as a delta.
+  BackendCaps Caps() const noexcept
+  {
+    BackendCaps caps = inner_.Caps();
+    caps.hw_scroll = false;
+    return caps;
+  }
+
+  LibXR::ErrorCode Present(const FrameView& frame, PresentMode mode) noexcept
+  {
+    const LibXR::ErrorCode STATUS = inner_.Present(frame, mode);
+    if (STATUS != LibXR::ErrorCode::OK)
+    {
+      return STATUS;
+    }
+    return Encode(frame, mode);
+  }
+
+  LibXR::ErrorCode SetPowerSave(bool enable) noexcept
+  {
+    return inner_.SetPowerSave(enable);
+  }
+
+  LibXR::ErrorCode SetContrast(uint8_t value) noexcept
+  {
+    return inner_.SetContrast(value);
+  }
+
+  // The next frame is sent as a keyframe, e.g. after a receiver connects.
+  void RequestKeyframe() noexcept { key_due_ = true; }
+
+  Inner& GetInner() noexcept { return inner_; }
+  Sink& GetSink() noexcept { return sink_; }
+
+ private:
+  struct Window
+  {
+    uint16_t line_begin{0};
+    uint16_t line_count{0};
+    uint16_t byte_begin{0};
+    uint16_t byte_count{0};
+  };
+
+  static constexpr std::size_t MAX_WINDOWS = PageDirtyMap::MAX_PAGES;
+  static constexpr uint8_t MAX_CHUNK = 128;
+
+  LibXR::ErrorCode Encode(const FrameView& frame, PresentMode mode) noexcept
+  {
+    const uint16_t LINES = layout_line_count(frame.height, frame.layout);
+    if (static_cast<std::size_t>(frame.stride_bytes) * LINES > kFrameBytes)
+    {
+      return LibXR::ErrorCode::SIZE_ERR;
+    }
+
+    if (frame.row_begin == 0 && !frame.continuation)
+    {
+      ++frames_since_key_;
+      if (key_due_ ||
+          (keyframe_interval_ != 0 && frames_since_key_ >= keyframe_interval_))
+      {
+        key_active_ = true;
+        key_due_ = false;
+        frames_since_key_ = 0;
+      }
+    }
+
+    // Page mode keyframes span one pass over all bands. The first chunk of a split
+    // present carries the key for its whole view, so later chunks go out as deltas.
+    const bool KEY = key_active_ && !frame.continuation;
+    if (frame.row_begin + frame.row_count >= frame.height)
+    {
+      key_active_ = false;
+    }
+
+    const bool VERTICAL = (frame.layout == PixelLayout::VERTICAL_PAGE);
+    const uint16_t FIRST_LINE =
+        VERTICAL ? static_cast<uint16_t>(frame.row_begin / 8U) : frame.row_begin;
+    const Rect STORED{0, static_cast<int16_t>(frame.row_begin), frame.width,
+                      frame.row_count};
+
+    std::array<Window, MAX_WINDOWS> windows{};
+    uint8_t window_count = 0;
+    auto add_window = [&](Rect rect)
+    {
+      const Rect CLIPPED = intersect_rect(rect, STORED);
+      if (rect_empty(CLIPPED) || window_count >= MAX_WINDOWS)
+      {
+        return;
+      }
+      const ByteWindow BYTES = layout_byte_window(CLIPPED, frame.layout);
+      windows[window_count] = Window{
+          BYTES.line_begin,
+          static_cast<uint16_t>(BYTES.line_end - BYTES.line_begin),
+          BYTES.byte_begin,
+          static_cast<uint16_t>(BYTES.byte_end - BYTES.byte_begin),
+      };
+      ++window_count;
+    };
+
+    if (KEY || mode == PresentMode::FULL || frame.dirty_rects == nullptr)
+    {
+      add_window(STORED);
+    }
+    else if (frame.page_dirty != nullptr)
+    {
+      for (uint8_t page = 0; page < frame.page_count; ++page)
+      {
+        const PageSpan SPAN = frame.page_dirty[page];
+        if (SPAN.x_end > SPAN.x_begin)
+        {
+          add_window(Rect{static_cast<int16_t>(SPAN.x_begin),
+                          static_cast<int16_t>(page * PageDirtyMap::PAGE_ROWS),
+                          static_cast<uint16_t>(SPAN.x_end - SPAN.x_begin),
+                          PageDirtyMap::PAGE_ROWS});
+        }
+      }
+    }
+    else
+    {
+      DirtyRegion region{};
+      for (uint8_t i = 0; i < frame.dirty_count; ++i)
+      {
+        region.Add(frame.dirty_rects[i]);
+      }
+      for (uint8_t i = 0; i < region.Count(); ++i)
+      {
+        add_window(region.Rects()[i]);
+      }
+    }
+
+    status_ = LibXR::ErrorCode::OK;
+    Put(STREAM_MAGIC);
+    Put(KEY ? STREAM_KEY : 0U);
+    PutU16(frame.width);
+    PutU16(frame.height);
+    Put(static_cast<uint8_t>(frame.layout));
+    Put(window_count);
+
+    for (uint8_t i = 0; i < window_count; ++i)
+    {
+      const Window& window = windows[i];
+      PutU16(window.line_begin);
+      PutU16(window.line_count);
+      PutU16(window.byte_begin);
+      PutU16(window.byte_count);
+
+      // Lines are XORed against the previous frame before that copy is updated, so
+      // overlapping windows encode the overlap once.
+      for (uint16_t line = window.line_begin;
+           line < window.line_begin + window.line_count; ++line)
+      {
+        const std::size_t ROW =
+            static_cast<std::size_t>(line - FIRST_LINE) * frame.stride_bytes;
+        const uint8_t* cur = frame.bits + ROW + window.byte_begin;
+        uint8_t* prev = previous_.data() +
+                        static_cast<std::size_t>(line) * frame.stride_bytes +
+                        window.byte_begin;
+        for (uint16_t byte = 0; byte < window.byte_count; ++byte)
+        {
+          RlePush(KEY ? cur[byte] : static_cast<uint8_t>(cur[byte] ^ prev[byte]));
+          prev[byte] = cur[byte];
+        }
+      }
+      RleFinish();
+    }
+    Flush();
+
+    if (status_ != LibXR::ErrorCode::OK)
+    {
+      // The receiver missed part of the stream; resync it with the next frame.
+      key_due_ = true;
+    }
+    return status_;
+  }
+
+  void RlePush(uint8_t value) noexcept
+  {
+    if (run_count_ != 0 && value == run_value_ && run_count_ < MAX_CHUNK)
+    {
+      ++run_count_;
+      return;
+    }
+    EndRun();
+    run_value_ = value;
+    run_count_ = 1;
+  }
+
+  // Runs shorter than three bytes are cheaper as literals.
+  void EndRun() noexcept
+  {
+    if (run_count_ >= 3)
+    {
+      FlushLiterals();
+      Put(static_cast<uint8_t>(0x80U | (run_count_ - 1U)));
+      Put(run_value_);
+    }
+    else
+    {
+      for (uint8_t i = 0; i < run_count_; ++i)
+      {
+        literals_[literal_count_] = run_value_;
+        ++literal_count_;
+        if (literal_count_ == MAX_CHUNK)
+        {
+          FlushLiterals();
+        }
+      }
+    }
+    run_count_ = 0;
+  }
+
+  void FlushLiterals() noexcept
+  {
+    if (literal_count_ == 0)
+    {
+      return;
+    }
+    Put(static_cast<uint8_t>(literal_count_ - 1U));
+    for (uint8_t i = 0; i < literal_count_; ++i)
+    {
+      Put(literals_[i]);
+    }
+    literal_count_ = 0;
+  }
+
+  void RleFinish() noexcept
+  {
+    EndRun();
+    FlushLiterals();
+  }
+
+  void PutU16(uint16_t value) noexcept
+  {
+    Put(static_cast<uint8_t>(value & 0xFFU));
+    Put(static_cast<uint8_t>(value >> 8));
+  }
+
+  void Put(uint8_t value) noexcept
+  {
+    out_[out_count_] = value;
+    ++out_count_;
+    if (out_count_ == out_.size())
+    {
+      Flush();
+    }
+  }
+
+  void Flush() noexcept
+  {
+    if (out_count_ == 0)
+    {
+      return;
+    }
+    const LibXR::ErrorCode STATUS = sink_.Write(out_.data(), out_count_);
+    if (status_ == LibXR::ErrorCode::OK)
+    {
+      status_ = STATUS;
+    }
+    out_count_ = 0;
+  }
+
+  Inner inner_;
+  Sink sink_;
+  uint16_t keyframe_interval_{30};
+  uint16_t frames_since_key_{0};
+  bool key_due_{true};
+  bool key_active_{false};
+  LibXR::ErrorCode status_{LibXR::ErrorCode::OK};
+  std::array<uint8_t, kFrameBytes> previous_{};
+  std::array<uint8_t, MAX_CHUNK> literals_{};
+  uint8_t literal_count_{0};
+  uint8_t run_value_{0};
+  uint8_t run_count_{0};
+  std::array<uint8_t, 64> out_{};
+  std::size_t out_count_{0};
+};
+
+// Rebuilds frames from a StreamEncoderBackend stream and presents them to Backend,
+// which must already be initialized for the same geometry. Deltas are dropped until the
+// first keyframe; a malformed packet drops sync until the next one.
+template <typename Backend, std::size_t kFrameBytes>
+class StreamDecoder
+{
+ public:
+  static_assert(kFrameBytes > 0, "kFrameBytes must be greater than 0.");
+
+  explicit StreamDecoder(Backend& backend) noexcept : backend_(backend) {}
+
+  // Accepts any slice of the stream. Returns the first failing Present status,
+  // ARG_ERR if malformed data was skipped, otherwise OK.
+  LibXR::ErrorCode Feed(const uint8_t* data, std::size_t size) noexcept
+  {
+    status_ = LibXR::ErrorCode::OK;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      Consume(data[i]);
+    }
+    return status_;
+  }
+
+  bool IsSynced() const noexcept { return synced_; }
+  const uint8_t* GetFrame() const noexcept { return frame_.data(); }
+
+ private:
+  enum class State : uint8_t
+  {
+    MAGIC,
+    HEADER,
+    WINDOW,
+    CONTROL,
+    LITERAL,
+    RUN
+  };
+
+  static constexpr uint8_t HEADER_BYTES = 7;
+  static constexpr uint8_t WINDOW_BYTES = 8;
+
+  uint16_t FieldU16(uint8_t offset) const noexcept
+  {
+    return static_cast<uint16_t>(field_[offset] | (field_[offset + 1U] << 8));
+  }
+
+  void Consume(uint8_t value) noexcept
+  {
+    switch (state_)
+    {
+      case State::MAGIC:
+        if (value == STREAM_MAGIC)
+        {
+          field_count_ = 0;
+          state_ = State::HEADER;
+        }
+        break;
+      case State::HEADER:
+        field_[field_count_] = value;
+        ++field_count_;
+        if (field_count_ == HEADER_BYTES)
+        {
+          BeginFrame();
+        }
+        break;
+      case State::WINDOW:
+        field_[field_count_] = value;
+        ++field_count_;
+        if (field_count_ == WINDOW_BYTES)
+        {
+          BeginWindow();
+        }
+        break;
+      case State::CONTROL:
+        chunk_left_ = static_cast<uint8_t>((value & 0x7FU) + 1U);
+        if (chunk_left_ > window_left_)
+        {
+          Fail();
+          break;
+        }
+        state_ = (value < 0x80U) ? State::LITERAL : State::RUN;
+        break;
+      case State::LITERAL:
+        Write(value);
+        --chunk_left_;
+        if (chunk_left_ == 0)
+        {
+          EndChunk();
+        }
+        break;
+      case State::RUN:
+        for (; chunk_left_ > 0; --chunk_left_)
+        {
+          Write(value);
+        }
+        EndChunk();
+        break;
+    }
+  }
+
+  void BeginFrame() noexcept
+  {
+    const bool KEY = (field_[0] & STREAM_KEY) != 0U;
+    const uint16_t WIDTH = FieldU16(1);
+    const uint16_t HEIGHT = FieldU16(3);
+    const uint8_t LAYOUT = field_[5];
+    windows_left_ = field_[6];
+    if (WIDTH == 0 || HEIGHT == 0 ||
+        LAYOUT > static_cast<uint8_t>(PixelLayout::VERTICAL_PAGE))
+    {
+      Fail();
+      return;
+    }
+
+    const PixelLayout PACKED = static_cast<PixelLayout>(LAYOUT);
+    const bool SAME =
+        synced_ && WIDTH == size_.w && HEIGHT == size_.h && PACKED == layout_;
+    if (KEY && !SAME)
+    {
+      const uint16_t STRIDE = layout_default_stride(WIDTH, PACKED);
+      const std::size_t BYTES =
+          static_cast<std::size_t>(STRIDE) * layout_line_count(HEIGHT, PACKED);
+      if (BYTES > kFrameBytes)
+      {
+        Fail();
+        return;
+      }
+      size_ = Size{WIDTH, HEIGHT};
+      layout_ = PACKED;
+      stride_ = STRIDE;
+      frame_.fill(0U);
+      synced_ = true;
+    }
+
+    key_ = KEY;
+    apply_ = KEY || SAME;
+    region_.Clear();
+    NextWindow();
+  }
+
+  void BeginWindow() noexcept
+  {
+    line_ = FieldU16(0);
+    const uint16_t LINE_COUNT = FieldU16(2);
+    byte_begin_ = FieldU16(4);
+    byte_count_ = FieldU16(6);
+    const uint32_t LINE_END = static_cast<uint32_t>(line_) + LINE_COUNT;
+    const uint32_t BYTE_END = static_cast<uint32_t>(byte_begin_) + byte_count_;
+    if (apply_ && (LINE_END > layout_line_count(size_.h, layout_) || BYTE_END > stride_))
+    {
+      Fail();
+      return;
+    }
+
+    if (apply_ && LINE_COUNT != 0 && byte_count_ != 0)
+    {
+      if (layout_ == PixelLayout::VERTICAL_PAGE)
+      {
+        region_.Add(intersect_rect(Rect{static_cast<int16_t>(byte_begin_),
+                                        static_cast<int16_t>(line_ * 8U), byte_count_,
+                                        static_cast<uint16_t>(LINE_COUNT * 8U)},
+                                   Rect{0, 0, size_.w, size_.h}));
+      }
+      else
+      {
+        region_.Add(intersect_rect(Rect{static_cast<int16_t>(byte_begin_ * 8U),
+                                        static_cast<int16_t>(line_),
+                                        static_cast<uint16_t>(byte_count_ * 8U),
+                                        LINE_COUNT},
+                                   Rect{0, 0, size_.w, size_.h}));
+      }
+    }
+
+    window_left_ = static_cast<uint32_t>(LINE_COUNT) * byte_count_;
+    column_ = 0;
+    state_ = State::CONTROL;
+    if (window_left_ == 0)
+    {
+      NextWindow();
+    }
+  }
+
+  void Write(uint8_t value) noexcept
+  {
+    if (apply_)
+    {
+      uint8_t& dst =
+          frame_[static_cast<std::size_t>(line_) * stride_ + byte_begin_ + column_];
+      dst = key_ ? value : static_cast<uint8_t>(dst ^ value);
+    }
+    --window_left_;
+    ++column_;
+    if (column_ == byte_count_)
+    {
+      column_ = 0;
+      ++line_;
+    }
+  }
+
+  void EndChunk() noexcept
+  {
+    state_ = State::CONTROL;
+    if (window_left_ == 0)
+    {
+      NextWindow();
+    }
+  }
+
+  void NextWindow() noexcept
+  {
+    if (windows_left_ == 0)
+    {
+      EndFrame();
+      return;
+    }
+    --windows_left_;
+    field_count_ = 0;
+    state_ = State::WINDOW;
+  }
+
+  void EndFrame() noexcept
+  {
+    state_ = State::MAGIC;
+    if (!apply_ || region_.Empty())
+    {
+      return;
+    }
+
+    const BackendCaps CAPS = backend_.Caps();
+    const PresentMode MODE =
+        (key_ || !CAPS.partial_update) ? PresentMode::FULL : PresentMode::DIRTY;
+    region_.ReduceTo(CAPS.max_dirty_rects);
+    const FrameView FRAME{
+        frame_.data(),
+        size_.w,
+        size_.h,
+        stride_,
+        region_.Bounds(),
+        0,
+        size_.h,
+        region_.Rects(),
+        region_.Count(),
+        nullptr,
+        0,
+        layout_,
+    };
+    const LibXR::ErrorCode STATUS = backend_.Present(FRAME, MODE);
+    if (STATUS != LibXR::ErrorCode::OK && status_ == LibXR::ErrorCode::OK)
+    {
+      status_ = STATUS;
+    }
+  }
+
+  void Fail() noexcept
+  {
+    synced_ = false;
+    state_ = State::MAGIC;
+    if (status_ == LibXR::ErrorCode::OK)
+    {
+      status_ = LibXR::ErrorCode::ARG_ERR;
+    }
+  }
+
+  Backend& backend_;
+  std::array<uint8_t, kFrameBytes> frame_{};
+  Size size_{};
+  PixelLayout layout_{PixelLayout::ROW_MAJOR_MSB};
+  uint16_t stride_{0};
+  bool synced_{false};
+  bool key_{false};
+  bool apply_{false};
+  DirtyRegion region_{};
+  State state_{State::MAGIC};
+  std::array<uint8_t, WINDOW_BYTES> field_{};
+  uint8_t field_count_{0};
+  uint8_t windows_left_{0};
+  uint16_t line_{0};
+  uint16_t byte_begin_{0};
+  uint16_t byte_count_{0};
+  uint16_t column_{0};
+  uint32_t window_left_{0};
+  uint8_t chunk_left_{0};
+  LibXR::ErrorCode status_{LibXR::ErrorCode::OK};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
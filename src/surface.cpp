@@ -5,6 +5,7 @@
 #include <cstring>
 
 #include "font.hpp"
+#include "glyph_cache.hpp"
 
 namespace LibXR
 {
@@ -13,8 +14,6 @@ namespace MonoGL
 namespace
 {
 
-Rect bounds_rect(Size size) noexcept { return Rect{0, 0, size.w, size.h}; }
-
 uint16_t default_stride(Size size) noexcept
 {
   if (size.w == 0)
@@ -24,54 +23,1782 @@ uint16_t default_stride(Size size) noexcept
   return static_cast<uint16_t>((size.w + 7U) / 8U);
 }
 
-int32_t font_ascent(const Font& font) noexcept
+// Compile-time pixel addressing, one policy per PixelLayout. y is relative to the
+// first row held by the buffer.
+struct RowMajorMsb
+{
+  static constexpr bool VERTICAL = false;
+  static constexpr bool MSB_FIRST = true;
+
+  static uint8_t* Byte(uint8_t* bits, uint16_t stride, int32_t x, int32_t y) noexcept
+  {
+    return bits + static_cast<std::size_t>(y) * stride + static_cast<std::size_t>(x / 8);
+  }
+
+  static uint8_t Mask(int32_t x, int32_t y) noexcept
+  {
+    static_cast<void>(y);
+    return static_cast<uint8_t>(0x80U >> (x & 0x7));
+  }
+};
+
+struct RowMajorLsb
+{
+  static constexpr bool VERTICAL = false;
+  static constexpr bool MSB_FIRST = false;
+
+  static uint8_t* Byte(uint8_t* bits, uint16_t stride, int32_t x, int32_t y) noexcept
+  {
+    return bits + static_cast<std::size_t>(y) * stride + static_cast<std::size_t>(x / 8);
+  }
+
+  static uint8_t Mask(int32_t x, int32_t y) noexcept
+  {
+    static_cast<void>(y);
+    return static_cast<uint8_t>(0x01U << (x & 0x7));
+  }
+};
+
+struct VerticalPage
+{
+  static constexpr bool VERTICAL = true;
+  static constexpr bool MSB_FIRST = false;
+
+  static uint8_t* Byte(uint8_t* bits, uint16_t stride, int32_t x, int32_t y) noexcept
+  {
+    return bits + static_cast<std::size_t>(y / 8) * stride + static_cast<std::size_t>(x);
+  }
+
+  static uint8_t Mask(int32_t x, int32_t y) noexcept
+  {
+    static_cast<void>(x);
+    return static_cast<uint8_t>(0x01U << (y & 0x7));
+  }
+};
+
+// Rotated (drawing) coordinates to panel coordinates; device is the panel size.
+Point rotate_point(int32_t x, int32_t y, Rotation rotation, Size device) noexcept
+{
+  switch (rotation)
+  {
+    case Rotation::R0:
+      break;
+    case Rotation::R90:
+      return Point{static_cast<int16_t>(device.w - 1 - y), static_cast<int16_t>(x)};
+    case Rotation::R180:
+      return Point{static_cast<int16_t>(device.w - 1 - x),
+                   static_cast<int16_t>(device.h - 1 - y)};
+    case Rotation::R270:
+      return Point{static_cast<int16_t>(y), static_cast<int16_t>(device.h - 1 - x)};
+  }
+  return Point{static_cast<int16_t>(x), static_cast<int16_t>(y)};
+}
+
+Rect rotate_rect(Rect rect, Rotation rotation, Size device) noexcept
+{
+  const int32_t X_END = rect.x + static_cast<int32_t>(rect.w);
+  const int32_t Y_END = rect.y + static_cast<int32_t>(rect.h);
+  switch (rotation)
+  {
+    case Rotation::R0:
+      break;
+    case Rotation::R90:
+      return Rect{static_cast<int16_t>(device.w - Y_END), rect.x, rect.h, rect.w};
+    case Rotation::R180:
+      return Rect{static_cast<int16_t>(device.w - X_END),
+                  static_cast<int16_t>(device.h - Y_END), rect.w, rect.h};
+    case Rotation::R270:
+      return Rect{rect.y, static_cast<int16_t>(device.h - X_END), rect.h, rect.w};
+  }
+  return rect;
+}
+
+// Inverse of rotate_rect.
+Rect unrotate_rect(Rect rect, Rotation rotation, Size device) noexcept
+{
+  const int32_t X_END = rect.x + static_cast<int32_t>(rect.w);
+  const int32_t Y_END = rect.y + static_cast<int32_t>(rect.h);
+  switch (rotation)
+  {
+    case Rotation::R0:
+      break;
+    case Rotation::R90:
+      return Rect{rect.y, static_cast<int16_t>(device.w - X_END), rect.h, rect.w};
+    case Rotation::R180:
+      return Rect{static_cast<int16_t>(device.w - X_END),
+                  static_cast<int16_t>(device.h - Y_END), rect.w, rect.h};
+    case Rotation::R270:
+      return Rect{static_cast<int16_t>(device.h - Y_END), rect.x, rect.h, rect.w};
+  }
+  return rect;
+}
+
+// Runs fn with the policy object of layout, so hot loops are specialized per layout
+// while the choice itself happens once per primitive.
+template <typename Fn>
+void with_layout(PixelLayout layout, Fn&& fn) noexcept
+{
+  switch (layout)
+  {
+    case PixelLayout::ROW_MAJOR_MSB:
+      fn(RowMajorMsb{});
+      break;
+    case PixelLayout::ROW_MAJOR_LSB:
+      fn(RowMajorLsb{});
+      break;
+    case PixelLayout::VERTICAL_PAGE:
+      fn(VerticalPage{});
+      break;
+  }
+}
+
+// Effect of a (color, raster_op) pair on every destination bit it covers.
+enum class SpanOp : uint8_t
+{
+  NONE = 0,
+  SET = 1,
+  CLEAR = 2,
+  TOGGLE = 3
+};
+
+SpanOp resolve_span_op(Color color, RasterOp raster_op) noexcept
+{
+  const bool SRC_IS_SET = (color == Color::WHITE);
+  switch (raster_op)
+  {
+    case RasterOp::COPY:
+      return SRC_IS_SET ? SpanOp::SET : SpanOp::CLEAR;
+    case RasterOp::XOR:
+      return SRC_IS_SET ? SpanOp::TOGGLE : SpanOp::NONE;
+    case RasterOp::AND:
+      return SRC_IS_SET ? SpanOp::NONE : SpanOp::CLEAR;
+    case RasterOp::OR:
+      return SRC_IS_SET ? SpanOp::SET : SpanOp::NONE;
+  }
+  return SpanOp::NONE;
+}
+
+void apply_mask(uint8_t& dst, uint8_t mask, SpanOp op) noexcept
+{
+  switch (op)
+  {
+    case SpanOp::NONE:
+      break;
+    case SpanOp::SET:
+      dst |= mask;
+      break;
+    case SpanOp::CLEAR:
+      dst &= static_cast<uint8_t>(~mask);
+      break;
+    case SpanOp::TOGGLE:
+      dst ^= mask;
+      break;
+  }
+}
+
+// Plots pixels of one primitive in drawing coordinates. The rotation is an affine map
+// and the layout a template argument, so per-pixel loops take no dispatch.
+template <typename Layout>
+struct PointPlotter
+{
+  uint8_t* bits;
+  uint16_t stride;
+  int32_t col_0;
+  int32_t col_x;
+  int32_t col_y;
+  int32_t row_0;
+  int32_t row_x;
+  int32_t row_y;
+  SpanOp op;
+
+  void operator()(int32_t x, int32_t y) const noexcept
+  {
+    const int32_t COL = col_0 + col_x * x + col_y * y;
+    const int32_t ROW = row_0 + row_x * x + row_y * y;
+    apply_mask(*Layout::Byte(bits, stride, COL, ROW), Layout::Mask(COL, ROW), op);
+  }
+};
+
+// Runs fn with the PointPlotter of a buffer whose first row is panel row band_y; the
+// choice of rotation and layout happens once, as in with_layout().
+template <typename Fn>
+void with_plotter(uint8_t* bits, uint16_t stride, PixelLayout layout, Rotation rotation,
+                  Size device, int32_t band_y, SpanOp op, Fn&& fn) noexcept
+{
+  // Same mapping as rotate_point().
+  int32_t col[3]{0, 1, 0};
+  int32_t row[3]{0, 0, 1};
+  switch (rotation)
+  {
+    case Rotation::R0:
+      break;
+    case Rotation::R90:
+      col[0] = device.w - 1;
+      col[1] = 0;
+      col[2] = -1;
+      row[1] = 1;
+      row[2] = 0;
+      break;
+    case Rotation::R180:
+      col[0] = device.w - 1;
+      col[1] = -1;
+      row[0] = device.h - 1;
+      row[2] = -1;
+      break;
+    case Rotation::R270:
+      col[1] = 0;
+      col[2] = 1;
+      row[0] = device.h - 1;
+      row[1] = -1;
+      row[2] = 0;
+      break;
+  }
+  row[0] -= band_y;
+  with_layout(layout,
+              [&](auto tag)
+              {
+                using Layout = decltype(tag);
+                fn(PointPlotter<Layout>{bits, stride, col[0], col[1], col[2], row[0],
+                                        row[1], row[2], op});
+              });
+}
+
+template <typename Word>
+void toggle_words(uint8_t*& dst, std::size_t& count) noexcept
+{
+  while (count >= sizeof(Word))
+  {
+    Word word;
+    std::memcpy(&word, dst, sizeof(Word));
+    word = static_cast<Word>(~word);
+    std::memcpy(dst, &word, sizeof(Word));
+    dst += sizeof(Word);
+    count -= sizeof(Word);
+  }
+}
+
+// Whole-byte middle of a span. SET/CLEAR are plain stores, TOGGLE walks 64/32/8-bit
+// words.
+void apply_full_bytes(uint8_t* dst, std::size_t count, SpanOp op) noexcept
+{
+  switch (op)
+  {
+    case SpanOp::NONE:
+      break;
+    case SpanOp::SET:
+      std::memset(dst, 0xFF, count);
+      break;
+    case SpanOp::CLEAR:
+      std::memset(dst, 0x00, count);
+      break;
+    case SpanOp::TOGGLE:
+      toggle_words<uint64_t>(dst, count);
+      toggle_words<uint32_t>(dst, count);
+      toggle_words<uint8_t>(dst, count);
+      break;
+  }
+}
+
+// Byte range and edge masks of a horizontal span [x_begin, x_end), computed once per
+// primitive.
+struct SpanMasks
+{
+  std::size_t first_byte{0};
+  std::size_t last_byte{0};
+  uint8_t head_mask{0};
+  uint8_t tail_mask{0};
+};
+
+SpanMasks make_span_masks(int32_t x_begin, int32_t x_end, bool msb_first) noexcept
+{
+  SpanMasks masks{};
+  masks.first_byte = static_cast<std::size_t>(x_begin) / 8U;
+  masks.last_byte = static_cast<std::size_t>(x_end - 1) / 8U;
+  if (msb_first)
+  {
+    masks.head_mask = static_cast<uint8_t>(0xFFU >> (x_begin & 0x7));
+    masks.tail_mask = static_cast<uint8_t>(0xFFU << (7 - ((x_end - 1) & 0x7)));
+  }
+  else
+  {
+    masks.head_mask = static_cast<uint8_t>(0xFFU << (x_begin & 0x7));
+    masks.tail_mask = static_cast<uint8_t>(0xFFU >> (7 - ((x_end - 1) & 0x7)));
+  }
+  if (masks.first_byte == masks.last_byte)
+  {
+    masks.head_mask &= masks.tail_mask;
+  }
+  return masks;
+}
+
+void apply_span(uint8_t* row, const SpanMasks& masks, SpanOp op) noexcept
+{
+  apply_mask(row[masks.first_byte], masks.head_mask, op);
+  if (masks.first_byte == masks.last_byte)
+  {
+    return;
+  }
+  apply_full_bytes(row + masks.first_byte + 1U, masks.last_byte - masks.first_byte - 1U,
+                   op);
+  apply_mask(row[masks.last_byte], masks.tail_mask, op);
+}
+
+// rect is relative to the buffer start and already clipped.
+template <typename Layout>
+void fill_rect(uint8_t* bits, uint16_t stride, Rect rect, SpanOp op) noexcept
+{
+  const int32_t X_BEGIN = rect.x;
+  const int32_t X_END = X_BEGIN + static_cast<int32_t>(rect.w);
+  const int32_t Y_BEGIN = rect.y;
+  const int32_t Y_END = Y_BEGIN + static_cast<int32_t>(rect.h);
+  if constexpr (Layout::VERTICAL)
+  {
+    // Each page is one contiguous byte run with a constant row mask.
+    for (int32_t page = Y_BEGIN / 8; page <= (Y_END - 1) / 8; ++page)
+    {
+      const int32_t LOW = std::max(Y_BEGIN - page * 8, int32_t{0});
+      const int32_t HIGH = std::min(Y_END - page * 8, int32_t{8});
+      const uint8_t MASK =
+          static_cast<uint8_t>((0xFFU << LOW) & (0xFFU >> (8 - HIGH)));
+      uint8_t* run = bits + static_cast<std::size_t>(page) * stride +
+                     static_cast<std::size_t>(X_BEGIN);
+      if (MASK == 0xFFU)
+      {
+        apply_full_bytes(run, rect.w, op);
+        continue;
+      }
+      for (uint16_t x = 0; x < rect.w; ++x)
+      {
+        apply_mask(run[x], MASK, op);
+      }
+    }
+  }
+  else
+  {
+    const SpanMasks MASKS = make_span_masks(X_BEGIN, X_END, Layout::MSB_FIRST);
+    uint8_t* row = bits + static_cast<std::size_t>(Y_BEGIN) * stride;
+    for (int32_t y = Y_BEGIN; y < Y_END; ++y)
+    {
+      apply_span(row, MASKS, op);
+      row += stride;
+    }
+  }
+}
+
+uint8_t reverse_bits(uint8_t value) noexcept
+{
+  value = static_cast<uint8_t>(((value & 0xF0U) >> 4) | ((value & 0x0FU) << 4));
+  value = static_cast<uint8_t>(((value & 0xCCU) >> 2) | ((value & 0x33U) << 2));
+  value = static_cast<uint8_t>(((value & 0xAAU) >> 1) | ((value & 0x55U) << 1));
+  return value;
+}
+
+// Eight MSB-first source bits starting at bit pos (pos > -8). Never reads the byte
+// after the one holding bit end_bit - 1; bits outside the image are masked by callers.
+uint8_t fetch_bits(const uint8_t* src, int32_t pos, int32_t end_bit) noexcept
+{
+  if (pos < 0)
+  {
+    return static_cast<uint8_t>(src[0] >> (-pos));
+  }
+  const int32_t INDEX = pos / 8;
+  const int32_t SHIFT = pos & 0x7;
+  uint8_t value = static_cast<uint8_t>(src[INDEX] << SHIFT);
+  if (SHIFT != 0 && (INDEX + 1) * 8 < end_bit)
+  {
+    value |= static_cast<uint8_t>(src[INDEX + 1] >> (8 - SHIFT));
+  }
+  return value;
+}
+
+// Per-byte merge shared by the bitmap and glyph blitters: bits are source pixels, mask
+// selects the destination bits to write.
+struct BlitMerge
+{
+  BitmapMode mode{BitmapMode::TRANSPARENT};
+  RasterOp raster_op{RasterOp::COPY};
+  bool foreground_set{true};
+  SpanOp span_op{SpanOp::NONE};  // Transparent mode: effect on set source bits.
+
+  void operator()(uint8_t& dst, uint8_t bits, uint8_t mask) const noexcept
+  {
+    if (mode == BitmapMode::TRANSPARENT)
+    {
+      apply_mask(dst, static_cast<uint8_t>(bits & mask), span_op);
+      return;
+    }
+
+    const uint8_t COLOR = foreground_set ? bits : static_cast<uint8_t>(~bits);
+    switch (raster_op)
+    {
+      case RasterOp::COPY:
+        dst = static_cast<uint8_t>((dst & ~mask) | (COLOR & mask));
+        break;
+      case RasterOp::XOR:
+        dst ^= static_cast<uint8_t>(COLOR & mask);
+        break;
+      case RasterOp::AND:
+        dst &= static_cast<uint8_t>(~mask | COLOR);
+        break;
+      case RasterOp::OR:
+        dst |= static_cast<uint8_t>(COLOR & mask);
+        break;
+    }
+  }
+};
+
+// Writes the pixels [x_begin, x_end) of a row-major destination row from a source row
+// read from bit src_begin, a destination byte at a time: source (and mask) bits are
+// shifted into byte alignment and merged under the span edge masks.
+template <typename Layout>
+void blit_row(uint8_t* row, int32_t x_begin, int32_t x_end, const uint8_t* src,
+              const uint8_t* mask_src, int32_t src_begin, const BlitMerge& merge) noexcept
+{
+  const SpanMasks MASKS = make_span_masks(x_begin, x_end, Layout::MSB_FIRST);
+  const int32_t SHIFT = src_begin - x_begin;
+  const int32_t SRC_END = src_begin + (x_end - x_begin);
+  for (std::size_t index = MASKS.first_byte; index <= MASKS.last_byte; ++index)
+  {
+    const int32_t POS = static_cast<int32_t>(index) * 8 + SHIFT;
+    uint8_t bits = fetch_bits(src, POS, SRC_END);
+    uint8_t mask = (mask_src != nullptr) ? fetch_bits(mask_src, POS, SRC_END) : 0xFFU;
+    if constexpr (!Layout::MSB_FIRST)
+    {
+      bits = reverse_bits(bits);
+      mask = reverse_bits(mask);
+    }
+    if (index == MASKS.first_byte)
+    {
+      mask &= MASKS.head_mask;
+    }
+    else if (index == MASKS.last_byte)
+    {
+      mask &= MASKS.tail_mask;
+    }
+    merge(row[index], bits, mask);
+  }
+}
+
+// Transposes an 8x8 bit matrix stored a row per byte, row 0 in the top byte and
+// column 0 in bit 7 of each.
+uint64_t transpose_8x8(uint64_t x) noexcept
+{
+  uint64_t t = (x ^ (x >> 7U)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7U);
+  t = (x ^ (x >> 14U)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14U);
+  t = (x ^ (x >> 28U)) & 0x00000000F0F0F0F0ULL;
+  return x ^ t ^ (t << 28U);
+}
+
+// Vertical-page counterpart of blit_row: writes the columns [x_begin, x_end) of one
+// page from up to eight MSB-first source rows, row k of the page in src[k] (nullptr
+// for rows outside the blit), read from bit src_begin. Each block of eight columns is
+// transposed into page bytes.
+void blit_page(uint8_t* line, int32_t x_begin, int32_t x_end,
+               const std::array<const uint8_t*, 8>& src,
+               const std::array<const uint8_t*, 8>& mask_src, int32_t src_begin,
+               const BlitMerge& merge) noexcept
+{
+  const int32_t SHIFT = src_begin - x_begin;
+  const int32_t SRC_END = src_begin + (x_end - x_begin);
+  for (int32_t x = x_begin; x < x_end; x += 8)
+  {
+    // Row k goes to the top byte 7 - k, so column bytes come out with row k in bit k.
+    uint64_t bits = 0;
+    uint64_t mask = 0;
+    for (uint32_t k = 0; k < 8U; ++k)
+    {
+      if (src[k] == nullptr)
+      {
+        continue;
+      }
+      const int32_t POS = x + SHIFT;
+      bits |= static_cast<uint64_t>(fetch_bits(src[k], POS, SRC_END)) << (8U * k);
+      const uint8_t ROW_MASK =
+          (mask_src[k] != nullptr) ? fetch_bits(mask_src[k], POS, SRC_END) : 0xFFU;
+      mask |= static_cast<uint64_t>(ROW_MASK) << (8U * k);
+    }
+    bits = transpose_8x8(bits);
+    mask = transpose_8x8(mask);
+    const int32_t COUNT = std::min<int32_t>(x_end - x, 8);
+    for (int32_t c = 0; c < COUNT; ++c)
+    {
+      const uint32_t BYTE_SHIFT = 8U * static_cast<uint32_t>(7 - c);
+      merge(line[x + c], static_cast<uint8_t>(bits >> BYTE_SHIFT),
+            static_cast<uint8_t>(mask >> BYTE_SHIFT));
+    }
+  }
+}
+
+// Ordered dithering thresholds: the 8x8 Bayer matrix b scaled to 4b + 2, so 0 stays
+// black and 255 white.
+constexpr std::array<std::array<uint8_t, 8>, 8> BAYER_THRESHOLDS{{
+    {{2, 130, 34, 162, 10, 138, 42, 170}},
+    {{194, 66, 226, 98, 202, 74, 234, 106}},
+    {{50, 178, 18, 146, 58, 186, 26, 154}},
+    {{242, 114, 210, 82, 250, 122, 218, 90}},
+    {{14, 142, 46, 174, 6, 134, 38, 166}},
+    {{206, 78, 238, 110, 198, 70, 230, 102}},
+    {{62, 190, 30, 158, 54, 182, 22, 150}},
+    {{254, 126, 222, 94, 246, 118, 214, 86}},
+}};
+constexpr std::array<uint8_t, 8> FLAT_THRESHOLDS{
+    {127, 127, 127, 127, 127, 127, 127, 127}};
+
+// DrawGray8() converts and blits rows this many pixels at a time.
+constexpr int32_t GRAY_CHUNK_PIXELS = 256;
+
+// Packs samples [begin, end) MSB-first into out, set where a sample is above its
+// threshold. begin is a multiple of 8, so thresholds[i] applies to bit i of each byte.
+void pack_ordered(const uint8_t* samples, int32_t begin, int32_t end,
+                  const uint8_t* thresholds, uint8_t* out) noexcept
+{
+  int32_t x = begin;
+  for (; x + 8 <= end; x += 8)
+  {
+    uint8_t bits = 0;
+    for (int32_t i = 0; i < 8; ++i)
+    {
+      bits |= static_cast<uint8_t>((samples[x + i] > thresholds[i] ? 1U : 0U) << (7 - i));
+    }
+    *out++ = bits;
+  }
+  if (x < end)
+  {
+    uint8_t bits = 0;
+    for (int32_t i = 0; x + i < end; ++i)
+    {
+      bits |= static_cast<uint8_t>((samples[x + i] > thresholds[i] ? 1U : 0U) << (7 - i));
+    }
+    *out = bits;
+  }
+}
+
+// Floyd-Steinberg, left to right. errors[x + 1] holds 16 times the error the row above
+// left for column x; once column x + 1 is done it holds the error for the row below, so
+// one row of entries serves both.
+struct ErrorDiffusion
+{
+  int16_t* errors{nullptr};
+  int32_t right{0};       // 7/16 share for the next pixel, times 16.
+  int32_t below_left{0};  // Row-below error for column x - 1 so far, times 16.
+  int32_t below{0};       // The same for column x.
+
+  void Pack(const uint8_t* samples, int32_t begin, int32_t end, uint8_t* out) noexcept
+  {
+    std::fill_n(out, static_cast<std::size_t>(end - begin + 7) / 8U, 0U);
+    for (int32_t x = begin; x < end; ++x)
+    {
+      const int32_t VALUE = samples[x] + (right + errors[x + 1]) / 16;
+      const bool WHITE = VALUE > 127;
+      const int32_t ERROR = VALUE - (WHITE ? 255 : 0);
+      if (WHITE)
+      {
+        out[(x - begin) / 8] |= static_cast<uint8_t>(0x80U >> ((x - begin) & 0x7));
+      }
+      right = ERROR * 7;
+      errors[x] = static_cast<int16_t>(below_left + ERROR * 3);
+      below_left = below + ERROR * 5;
+      below = ERROR;
+    }
+  }
+
+  void EndRow(int32_t width) noexcept
+  {
+    errors[width] = static_cast<int16_t>(below_left);
+    right = 0;
+    below_left = 0;
+    below = 0;
+  }
+
+  // A row left untouched; the error diffused into it is dropped, not carried on.
+  void SkipRow(int32_t width) noexcept
+  {
+    std::fill_n(errors, static_cast<std::size_t>(width) + 1U, static_cast<int16_t>(0));
+    right = 0;
+    below_left = 0;
+    below = 0;
+  }
+};
+
+struct GrayImage
+{
+  const uint8_t* samples{nullptr};
+  std::size_t stride{0};
+};
+
+const uint8_t* gray_image_row(void* context, uint16_t y) noexcept
+{
+  const GrayImage& image = *static_cast<const GrayImage*>(context);
+  return image.samples + static_cast<std::size_t>(y) * image.stride;
+}
+
+// CopyRect() walks bit lines: pixel rows of row-major layouts, pixel columns of
+// VERTICAL_PAGE, whose byte i sits at base + i * step. Bytes are read MSB-first
+// whatever the layout's bit order.
+template <typename Layout>
+uint8_t line_byte(const uint8_t* base, std::size_t step, int32_t index) noexcept
+{
+  const uint8_t VALUE = base[static_cast<std::size_t>(index) * step];
+  return Layout::MSB_FIRST ? VALUE : reverse_bits(VALUE);
+}
+
+// fetch_bits() along a bit line.
+template <typename Layout>
+uint8_t fetch_line_bits(const uint8_t* base, std::size_t step, int32_t pos,
+                        int32_t end_bit) noexcept
+{
+  if (pos < 0)
+  {
+    return static_cast<uint8_t>(line_byte<Layout>(base, step, 0) >> (-pos));
+  }
+  const int32_t INDEX = pos / 8;
+  const int32_t SHIFT = pos & 0x7;
+  uint8_t value = static_cast<uint8_t>(line_byte<Layout>(base, step, INDEX) << SHIFT);
+  if (SHIFT != 0 && (INDEX + 1) * 8 < end_bit)
+  {
+    value |=
+        static_cast<uint8_t>(line_byte<Layout>(base, step, INDEX + 1) >> (8 - SHIFT));
+  }
+  return value;
+}
+
+// Eight row bytes as one word whose bit order is the pixel order: the first byte is
+// the most significant for MSB-first rows and the least significant otherwise. Spelled
+// out so compilers see a plain (byte-swapped) load and store.
+uint64_t load_be64(const uint8_t* b) noexcept
+{
+  return (static_cast<uint64_t>(b[0]) << 56U) | (static_cast<uint64_t>(b[1]) << 48U) |
+         (static_cast<uint64_t>(b[2]) << 40U) | (static_cast<uint64_t>(b[3]) << 32U) |
+         (static_cast<uint64_t>(b[4]) << 24U) | (static_cast<uint64_t>(b[5]) << 16U) |
+         (static_cast<uint64_t>(b[6]) << 8U) | static_cast<uint64_t>(b[7]);
+}
+
+uint64_t load_le64(const uint8_t* b) noexcept
+{
+  return (static_cast<uint64_t>(b[7]) << 56U) | (static_cast<uint64_t>(b[6]) << 48U) |
+         (static_cast<uint64_t>(b[5]) << 40U) | (static_cast<uint64_t>(b[4]) << 32U) |
+         (static_cast<uint64_t>(b[3]) << 24U) | (static_cast<uint64_t>(b[2]) << 16U) |
+         (static_cast<uint64_t>(b[1]) << 8U) | static_cast<uint64_t>(b[0]);
+}
+
+void store_be64(uint8_t* b, uint64_t word) noexcept
+{
+  b[0] = static_cast<uint8_t>(word >> 56U);
+  b[1] = static_cast<uint8_t>(word >> 48U);
+  b[2] = static_cast<uint8_t>(word >> 40U);
+  b[3] = static_cast<uint8_t>(word >> 32U);
+  b[4] = static_cast<uint8_t>(word >> 24U);
+  b[5] = static_cast<uint8_t>(word >> 16U);
+  b[6] = static_cast<uint8_t>(word >> 8U);
+  b[7] = static_cast<uint8_t>(word);
+}
+
+void store_le64(uint8_t* b, uint64_t word) noexcept
+{
+  b[7] = static_cast<uint8_t>(word >> 56U);
+  b[6] = static_cast<uint8_t>(word >> 48U);
+  b[5] = static_cast<uint8_t>(word >> 40U);
+  b[4] = static_cast<uint8_t>(word >> 32U);
+  b[3] = static_cast<uint8_t>(word >> 24U);
+  b[2] = static_cast<uint8_t>(word >> 16U);
+  b[1] = static_cast<uint8_t>(word >> 8U);
+  b[0] = static_cast<uint8_t>(word);
+}
+
+template <typename Layout>
+uint64_t load_row_word(const uint8_t* bytes) noexcept
+{
+  return Layout::MSB_FIRST ? load_be64(bytes) : load_le64(bytes);
+}
+
+template <typename Layout>
+void store_row_word(uint8_t* bytes, uint64_t word) noexcept
+{
+  if constexpr (Layout::MSB_FIRST)
+  {
+    store_be64(bytes, word);
+  }
+  else
+  {
+    store_le64(bytes, word);
+  }
+}
+
+// Destination bytes [begin, end) of a bit line, wholly covered by the copy. In a row
+// each is two neighbouring source bytes shifted together, a word at a time where it
+// can; shift (in bits) is not a multiple of 8 there. Walks down when shift < 0.
+template <typename Layout>
+void copy_line_whole(const uint8_t* src, uint8_t* dst, std::size_t step,
+                     std::size_t begin, std::size_t end, int32_t shift) noexcept
+{
+  if (end <= begin)
+  {
+    return;
+  }
+  if constexpr (Layout::VERTICAL)
+  {
+    const int32_t SRC_END = static_cast<int32_t>(end) * 8 + shift;
+    const auto COPY = [&](std::size_t index)
+    {
+      const uint8_t BITS = fetch_line_bits<Layout>(
+          src, step, static_cast<int32_t>(index) * 8 + shift, SRC_END);
+      dst[index * step] = reverse_bits(BITS);  // Pages are LSB-first.
+    };
+    if (shift < 0)
+    {
+      for (std::size_t index = end; index-- > begin;)
+      {
+        COPY(index);
+      }
+      return;
+    }
+    for (std::size_t index = begin; index < end; ++index)
+    {
+      COPY(index);
+    }
+  }
+  else
+  {
+    static_cast<void>(step);
+    // Destination byte index starts BIT bits into source byte index + OFFSET.
+    const uint32_t BIT = static_cast<uint32_t>(shift & 0x7);
+    const std::ptrdiff_t OFFSET = (shift - static_cast<int32_t>(BIT)) / 8;
+    const auto SHIFTED = [&](uint64_t word, uint8_t next)
+    {
+      const uint64_t NEXT = next;
+      return Layout::MSB_FIRST ? (word << BIT) | (NEXT >> (8U - BIT))
+                               : (word >> BIT) | (NEXT << (64U - BIT));
+    };
+    const auto COPY_BYTE = [&](std::size_t index)
+    {
+      const uint8_t* from = src + static_cast<std::ptrdiff_t>(index) + OFFSET;
+      dst[index] = Layout::MSB_FIRST
+                       ? static_cast<uint8_t>((from[0] << BIT) | (from[1] >> (8U - BIT)))
+                       : static_cast<uint8_t>((from[0] >> BIT) | (from[1] << (8U - BIT)));
+    };
+    const auto COPY_WORD = [&](std::size_t index)
+    {
+      const uint8_t* from = src + static_cast<std::ptrdiff_t>(index) + OFFSET;
+      store_row_word<Layout>(dst + index, SHIFTED(load_row_word<Layout>(from), from[8]));
+    };
+
+    if (shift < 0)
+    {
+      std::size_t index = end;
+      for (; index >= begin + 8U; index -= 8U)
+      {
+        COPY_WORD(index - 8U);
+      }
+      while (index-- > begin)
+      {
+        COPY_BYTE(index);
+      }
+      return;
+    }
+    std::size_t index = begin;
+    for (; index + 8U <= end; index += 8U)
+    {
+      COPY_WORD(index);
+    }
+    for (; index < end; ++index)
+    {
+      COPY_BYTE(index);
+    }
+  }
+}
+
+// Copies count bits of a line from bit src_begin to bit dst_begin of another (or the
+// same) line. The walk runs against the direction of the move, so an aliased line
+// never reads bits it has already written.
+template <typename Layout>
+void copy_line_bits(const uint8_t* src, uint8_t* dst, std::size_t step,
+                    int32_t src_begin, int32_t dst_begin, int32_t count) noexcept
+{
+  const SpanMasks MASKS = make_span_masks(dst_begin, dst_begin + count, true);
+  const int32_t SHIFT = src_begin - dst_begin;
+  const int32_t SRC_END = src_begin + count;
+  const auto COPY_EDGE = [&](std::size_t index, uint8_t mask)
+  {
+    const int32_t POS = static_cast<int32_t>(index) * 8 + SHIFT;
+    uint8_t bits = fetch_line_bits<Layout>(src, step, POS, SRC_END);
+    if constexpr (!Layout::MSB_FIRST)
+    {
+      bits = reverse_bits(bits);
+      mask = reverse_bits(mask);
+    }
+    uint8_t& byte = dst[index * step];
+    byte = static_cast<uint8_t>((byte & ~mask) | (bits & mask));
+  };
+  const std::size_t FIRST = MASKS.first_byte;
+  const std::size_t LAST = MASKS.last_byte;
+  if (SHIFT < 0)
+  {
+    if (LAST != FIRST)
+    {
+      COPY_EDGE(LAST, MASKS.tail_mask);
+    }
+    copy_line_whole<Layout>(src, dst, step, FIRST + 1U, LAST, SHIFT);
+    COPY_EDGE(FIRST, MASKS.head_mask);
+    return;
+  }
+  COPY_EDGE(FIRST, MASKS.head_mask);
+  copy_line_whole<Layout>(src, dst, step, FIRST + 1U, LAST, SHIFT);
+  if (LAST != FIRST)
+  {
+    COPY_EDGE(LAST, MASKS.tail_mask);
+  }
+}
+
+// Row copy whose source and destination share their bit offset within a byte: the
+// whole bytes are one memmove. The edge bytes are read before it may overwrite them.
+void copy_row_aligned(const uint8_t* src, uint8_t* dst, int32_t src_begin,
+                      int32_t dst_begin, int32_t count, bool msb_first) noexcept
+{
+  const SpanMasks MASKS = make_span_masks(dst_begin, dst_begin + count, msb_first);
+  const std::size_t SRC_FIRST = static_cast<std::size_t>(src_begin) / 8U;
+  const std::size_t SPAN = MASKS.last_byte - MASKS.first_byte;
+  const uint8_t HEAD = src[SRC_FIRST];
+  const uint8_t TAIL = src[SRC_FIRST + SPAN];
+  if (SPAN > 1U)
+  {
+    std::memmove(dst + MASKS.first_byte + 1U, src + SRC_FIRST + 1U, SPAN - 1U);
+  }
+  uint8_t& head = dst[MASKS.first_byte];
+  head = static_cast<uint8_t>((head & ~MASKS.head_mask) | (HEAD & MASKS.head_mask));
+  if (MASKS.last_byte != MASKS.first_byte)
+  {
+    uint8_t& tail = dst[MASKS.last_byte];
+    tail = static_cast<uint8_t>((tail & ~MASKS.tail_mask) | (TAIL & MASKS.tail_mask));
+  }
+}
+
+// Page copy for a vertical move by whole pages: each page of the destination is one
+// run of bytes taken from the same columns of the source page.
+void copy_pages_aligned(uint8_t* bits, uint16_t stride, Rect src, Point dst) noexcept
+{
+  const int32_t Y_BEGIN = dst.y;
+  const int32_t Y_END = Y_BEGIN + static_cast<int32_t>(src.h);
+  const int32_t PAGE_SHIFT = (src.y - dst.y) / 8;
+  const int32_t FIRST = Y_BEGIN / 8;
+  const int32_t LAST = (Y_END - 1) / 8;
+  const bool DOWN = PAGE_SHIFT < 0;
+  const bool RIGHT = dst.x > src.x;
+  for (int32_t i = 0; i <= LAST - FIRST; ++i)
+  {
+    const int32_t PAGE = DOWN ? LAST - i : FIRST + i;
+    const int32_t LOW = std::max(Y_BEGIN - PAGE * 8, int32_t{0});
+    const int32_t HIGH = std::min(Y_END - PAGE * 8, int32_t{8});
+    const uint8_t MASK = static_cast<uint8_t>((0xFFU << LOW) & (0xFFU >> (8 - HIGH)));
+    uint8_t* run =
+        bits + static_cast<std::size_t>(PAGE) * stride + static_cast<std::size_t>(dst.x);
+    const uint8_t* from = bits + static_cast<std::size_t>(PAGE + PAGE_SHIFT) * stride +
+                          static_cast<std::size_t>(src.x);
+    if (MASK == 0xFFU)
+    {
+      std::memmove(run, from, src.w);
+      continue;
+    }
+    for (uint16_t n = 0; n < src.w; ++n)
+    {
+      const uint16_t X = RIGHT ? static_cast<uint16_t>(src.w - 1U - n) : n;
+      run[X] = static_cast<uint8_t>((run[X] & ~MASK) | (from[X] & MASK));
+    }
+  }
+}
+
+// src and dst_top_left are relative to the buffer start; both rects lie inside it.
+template <typename Layout>
+void copy_rect(uint8_t* bits, uint16_t stride, Rect src, Point dst) noexcept
+{
+  if constexpr (Layout::VERTICAL)
+  {
+    if ((src.y - dst.y) % 8 == 0)
+    {
+      copy_pages_aligned(bits, stride, src, dst);
+      return;
+    }
+    // Columns are independent lines; right to left when moving right.
+    const bool BACKWARD = dst.x > src.x;
+    for (uint16_t n = 0; n < src.w; ++n)
+    {
+      const int32_t I = BACKWARD ? static_cast<int32_t>(src.w) - 1 - n : n;
+      copy_line_bits<Layout>(bits + src.x + I, bits + dst.x + I, stride, src.y, dst.y,
+                             src.h);
+    }
+  }
+  else
+  {
+    const bool ALIGNED = ((src.x - dst.x) & 0x7) == 0;
+    const bool BACKWARD = dst.y > src.y;
+    for (uint16_t n = 0; n < src.h; ++n)
+    {
+      const int32_t I = BACKWARD ? static_cast<int32_t>(src.h) - 1 - n : n;
+      const uint8_t* from = bits + static_cast<std::size_t>(src.y + I) * stride;
+      uint8_t* row = bits + static_cast<std::size_t>(dst.y + I) * stride;
+      if (ALIGNED)
+      {
+        copy_row_aligned(from, row, src.x, dst.x, src.w, Layout::MSB_FIRST);
+      }
+      else
+      {
+        copy_line_bits<Layout>(from, row, 1U, src.x, dst.x, src.w);
+      }
+    }
+  }
+}
+
+bool rects_touch(Rect a, Rect b) noexcept
+{
+  return a.x <= b.x + static_cast<int32_t>(b.w) &&
+         b.x <= a.x + static_cast<int32_t>(a.w) &&
+         a.y <= b.y + static_cast<int32_t>(b.h) && b.y <= a.y + static_cast<int32_t>(a.h);
+}
+
+int64_t rect_area(Rect rect) noexcept
+{
+  return static_cast<int64_t>(rect.w) * static_cast<int64_t>(rect.h);
+}
+
+// Pixels a merged rect covers that neither input did (negative when they overlap).
+int64_t merge_cost(Rect a, Rect b) noexcept
+{
+  return rect_area(union_rect(a, b)) - rect_area(a) - rect_area(b);
+}
+
+// Index of the first byte in [begin, end) where a and b differ, or end.
+std::size_t first_diff_byte(const uint8_t* a, const uint8_t* b, std::size_t begin,
+                            std::size_t end) noexcept
+{
+  std::size_t index = begin;
+  while (index + sizeof(uint64_t) <= end)
+  {
+    uint64_t word_a = 0;
+    uint64_t word_b = 0;
+    std::memcpy(&word_a, a + index, sizeof(word_a));
+    std::memcpy(&word_b, b + index, sizeof(word_b));
+    if ((word_a ^ word_b) != 0U)
+    {
+      break;
+    }
+    index += sizeof(uint64_t);
+  }
+  while (index < end && a[index] == b[index])
+  {
+    ++index;
+  }
+  return index;
+}
+
+// One past the last byte in [begin, end) where a and b differ, or begin.
+std::size_t last_diff_byte(const uint8_t* a, const uint8_t* b, std::size_t begin,
+                           std::size_t end) noexcept
+{
+  std::size_t index = end;
+  while (index >= begin + sizeof(uint64_t))
+  {
+    uint64_t word_a = 0;
+    uint64_t word_b = 0;
+    std::memcpy(&word_a, a + index - sizeof(uint64_t), sizeof(word_a));
+    std::memcpy(&word_b, b + index - sizeof(uint64_t), sizeof(word_b));
+    if ((word_a ^ word_b) != 0U)
+    {
+      break;
+    }
+    index -= sizeof(uint64_t);
+  }
+  while (index > begin && a[index - 1] == b[index - 1])
+  {
+    --index;
+  }
+  return index;
+}
+
+// OR of a ^ b over [begin, end), folded into one byte.
+uint8_t diff_bits(const uint8_t* a, const uint8_t* b, std::size_t begin,
+                  std::size_t end) noexcept
+{
+  uint64_t folded = 0;
+  std::size_t index = begin;
+  for (; index + sizeof(uint64_t) <= end; index += sizeof(uint64_t))
+  {
+    uint64_t word_a = 0;
+    uint64_t word_b = 0;
+    std::memcpy(&word_a, a + index, sizeof(word_a));
+    std::memcpy(&word_b, b + index, sizeof(word_b));
+    folded |= word_a ^ word_b;
+  }
+  uint8_t bits = 0;
+  for (uint8_t shift = 0; shift < 64; shift = static_cast<uint8_t>(shift + 8))
+  {
+    bits = static_cast<uint8_t>(bits | (folded >> shift));
+  }
+  for (; index < end; ++index)
+  {
+    bits = static_cast<uint8_t>(bits | (a[index] ^ b[index]));
+  }
+  return bits;
+}
+
+// value must be non-zero.
+int32_t lowest_bit(uint8_t value) noexcept
+{
+  int32_t bit = 0;
+  while ((value & (1U << bit)) == 0U)
+  {
+    ++bit;
+  }
+  return bit;
+}
+
+int32_t highest_bit(uint8_t value) noexcept
+{
+  int32_t bit = 7;
+  while ((value & (1U << bit)) == 0U)
+  {
+    --bit;
+  }
+  return bit;
+}
+
+int32_t font_ascent(const Font& font) noexcept
+{
+  if (font.ascent == 0)
+  {
+    return static_cast<int32_t>(font.glyph_height);
+  }
+  return static_cast<int32_t>(font.ascent);
+}
+
+int32_t font_descent(const Font& font) noexcept
+{
+  return static_cast<int32_t>(font.descent);
+}
+
+int32_t font_line_height(const Font& font) noexcept
+{
+  const int32_t LINE_HEIGHT = font_ascent(font) + font_descent(font);
+  if (LINE_HEIGHT <= 0)
+  {
+    return static_cast<int32_t>(font.glyph_height);
+  }
+  return LINE_HEIGHT;
+}
+
+// One glyph of a text run at its scale, relative to the pen on the baseline.
+struct GlyphPlacement
+{
+  bool present{false};
+  uint16_t index{0};  // Glyph index when present.
+  int32_t x_offset{0};
+  int32_t top{0};  // Top row relative to the baseline; negative is above it.
+  uint16_t w{0};
+  uint16_t h{0};
+  int32_t advance{0};  // Without letter spacing.
+};
+
+GlyphPlacement place_glyph(const Font& font, uint32_t codepoint, uint8_t scale_x,
+                           uint8_t scale_y) noexcept
+{
+  GlyphPlacement place{};
+  place.advance = static_cast<int32_t>(font.glyph_width) * scale_x;
+  if (!font_glyph_index(font, codepoint, place.index))
+  {
+    return place;
+  }
+  place.present = true;
+  if (font.format == FontFormat::RLE)
+  {
+    const FontGlyph& glyph = font.glyph_table[place.index];
+    place.x_offset = static_cast<int32_t>(glyph.x_offset) * scale_x;
+    place.top = -static_cast<int32_t>(glyph.y_offset) * scale_y;
+    place.w = static_cast<uint16_t>(glyph.width * scale_x);
+    place.h = static_cast<uint16_t>(glyph.height * scale_y);
+    place.advance = static_cast<int32_t>(glyph.advance) * scale_x;
+    return place;
+  }
+  place.top = -font_ascent(font) * scale_y;
+  place.w = static_cast<uint16_t>(font.glyph_width * scale_x);
+  place.h = static_cast<uint16_t>(font.glyph_height * scale_y);
+  return place;
+}
+
+// MSB-first reader over FontFormat::RLE run data.
+class BitReader
+{
+ public:
+  BitReader(const uint8_t* data, uint32_t bit) noexcept : data_(data), bit_(bit) {}
+
+  uint32_t Read(uint8_t bits) noexcept
+  {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bits; ++i)
+    {
+      const uint8_t BYTE = data_[bit_ >> 3U];
+      value = (value << 1U) | ((BYTE >> (7U - (bit_ & 7U))) & 1U);
+      ++bit_;
+    }
+    return value;
+  }
+
+ private:
+  const uint8_t* data_;
+  uint32_t bit_;
+};
+
+// Calls run(first_pixel, length) for every run of set pixels of glyph, in scan order.
+// Runs may span rows.
+template <typename RunFn>
+void decode_rle_glyph(const Font& font, const FontGlyph& glyph, RunFn&& run) noexcept
+{
+  const uint32_t TOTAL = static_cast<uint32_t>(glyph.width) * glyph.height;
+  if (TOTAL == 0 || (font.zero_bits == 0 && font.one_bits == 0))
+  {
+    return;
+  }
+
+  BitReader reader(font.glyphs, glyph.Offset() * 8U);
+  uint32_t pos = 0;
+  while (pos < TOTAL)
+  {
+    const uint32_t ZEROS = reader.Read(font.zero_bits);
+    const uint32_t ONES = reader.Read(font.one_bits);
+    do
+    {
+      pos += ZEROS;
+      if (ONES != 0U && pos < TOTAL)
+      {
+        run(pos, std::min(ONES, TOTAL - pos));
+      }
+      pos += ONES;
+    } while (pos < TOTAL && reader.Read(1) != 0U);
+  }
+}
+
+// Bounding box of the round shape spanned by inner's corners and the radii.
+Rect round_box(Rect inner, uint8_t radius_x, uint8_t radius_y) noexcept
+{
+  return Rect{
+      static_cast<int16_t>(inner.x - radius_x),
+      static_cast<int16_t>(inner.y - radius_y),
+      static_cast<uint16_t>(inner.w + 2U * radius_x),
+      static_cast<uint16_t>(inner.h + 2U * radius_y),
+  };
+}
+
+// radius, limited so the corner arcs of rect do not overlap.
+uint8_t round_rect_radius(Rect rect, uint8_t radius) noexcept
+{
+  const uint16_t LIMIT = static_cast<uint16_t>((std::min(rect.w, rect.h) - 1U) / 2U);
+  return static_cast<uint8_t>(std::min<uint16_t>(radius, LIMIT));
+}
+
+// Rect through the centres of the corner arcs.
+Rect round_rect_inner(Rect rect, uint8_t radius) noexcept
+{
+  return Rect{
+      static_cast<int16_t>(rect.x + radius),
+      static_cast<int16_t>(rect.y + radius),
+      static_cast<uint16_t>(rect.w - 2U * radius),
+      static_cast<uint16_t>(rect.h - 2U * radius),
+  };
+}
+
+// Calls point(a, b) once for every first-quadrant offset of the midpoint circle.
+template <typename PointFn>
+void circle_quadrant(uint8_t radius, PointFn&& point) noexcept
+{
+  int32_t x = radius;
+  int32_t y = 0;
+  int32_t err = 1 - x;
+  while (x >= y)
+  {
+    point(x, y);
+    if (x != y)
+    {
+      point(y, x);
+    }
+    ++y;
+    if (err < 0)
+    {
+      err += 2 * y + 1;
+    }
+    else
+    {
+      --x;
+      err += 2 * (y - x + 1);
+    }
+  }
+}
+
+// Calls row(dy, half_width) once for every dy in [0, radius] with the widest offset
+// circle_quadrant() reaches on that row.
+template <typename RowFn>
+void circle_rows(uint8_t radius, RowFn&& row) noexcept
+{
+  int32_t x = radius;
+  int32_t y = 0;
+  int32_t err = 1 - x;
+  while (x >= y)
+  {
+    row(y, x);
+    const int32_t LAST_X = x;
+    const int32_t LAST_Y = y;
+    ++y;
+    if (err < 0)
+    {
+      err += 2 * y + 1;
+    }
+    else
+    {
+      --x;
+      err += 2 * (y - x + 1);
+    }
+    // Row LAST_X is final once x moves on; rows up to LAST_Y came from the loop above.
+    if (x != LAST_X && LAST_X > LAST_Y)
+    {
+      row(LAST_X, LAST_Y);
+    }
+  }
+}
+
+// Calls row(dy, half_width) for dy = radius_y down to 0, half_width being the widest x
+// with x^2 / (radius_x + 1/2)^2 + dy^2 / (radius_y + 1/2)^2 <= 1.
+template <typename RowFn>
+void ellipse_rows(uint8_t radius_x, uint8_t radius_y, RowFn&& row) noexcept
+{
+  const int64_t AX = (2 * static_cast<int64_t>(radius_x) + 1) *
+                     (2 * static_cast<int64_t>(radius_x) + 1);
+  const int64_t BY = (2 * static_cast<int64_t>(radius_y) + 1) *
+                     (2 * static_cast<int64_t>(radius_y) + 1);
+  const int64_t LIMIT = AX * BY;
+  int32_t x = 0;
+  for (int32_t dy = radius_y; dy >= 0; --dy)
+  {
+    const int64_t ROW = 4 * static_cast<int64_t>(dy) * dy * AX;
+    while (x < radius_x && 4 * static_cast<int64_t>(x + 1) * (x + 1) * BY + ROW <= LIMIT)
+    {
+      ++x;
+    }
+    row(dy, x);
+  }
+}
+
+// First-quadrant outline of ellipse_rows(): each row continues from where the row
+// below it ends, so the arc stays 8-connected.
+template <typename PointFn>
+void ellipse_quadrant(uint8_t radius_x, uint8_t radius_y, PointFn&& point) noexcept
+{
+  int32_t outer = -1;
+  ellipse_rows(radius_x, radius_y,
+               [&](int32_t dy, int32_t half_width)
+               {
+                 for (int32_t a = std::min(outer + 1, half_width); a <= half_width; ++a)
+                 {
+                   point(a, dy);
+                 }
+                 outer = half_width;
+               });
+}
+
+// Baseline step between text lines.
+int32_t text_line_pitch(const Font& font, uint8_t scale_y) noexcept
+{
+  return font_line_height(font) * scale_y + 1;
+}
+
+// text_bounds() of the text up to end or NUL.
+Rect text_span_bounds(Point baseline_left, const char* text, const char* end,
+                      const TextStyle& style) noexcept
+{
+  if (text == nullptr || style.font == nullptr)
+  {
+    return Rect{};
+  }
+
+  const Font& font = *style.font;
+  const uint8_t SCALE_X = (style.scale_x == 0) ? 1 : style.scale_x;
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  const int32_t LINE_PITCH = text_line_pitch(font, SCALE_Y);
+
+  // Same layout as Surface::DrawTextSpan().
+  Rect bounds{};
+  int32_t cursor_x = baseline_left.x;
+  int32_t baseline_y = baseline_left.y;
+  for (const char* p = text; p != end && *p != '\0';)
+  {
+    const uint32_t CODEPOINT = utf8_next(p);
+    if (CODEPOINT == '\n')
+    {
+      cursor_x = baseline_left.x;
+      baseline_y += LINE_PITCH;
+      continue;
+    }
+    const GlyphPlacement PLACE = place_glyph(font, CODEPOINT, SCALE_X, SCALE_Y);
+    if (PLACE.present)
+    {
+      const Rect GLYPH{static_cast<int16_t>(cursor_x + PLACE.x_offset),
+                       static_cast<int16_t>(baseline_y + PLACE.top), PLACE.w, PLACE.h};
+      bounds = union_rect(bounds, GLYPH);
+    }
+    cursor_x += PLACE.advance + style.letter_spacing;
+  }
+  return bounds;
+}
+
+// Pen advance of the line at text without the spacing after its last glyph. Stops at
+// '\n' or NUL and leaves text there.
+int32_t line_advance(const Font& font, const char*& text, uint8_t scale_x,
+                     int8_t letter_spacing) noexcept
+{
+  int32_t pen = 0;
+  int32_t width = 0;
+  while (*text != '\0' && *text != '\n')
+  {
+    width = pen + place_glyph(font, utf8_next(text), scale_x, 1).advance;
+    pen = width + letter_spacing;
+  }
+  return width;
+}
+
+int16_t clamp_text_width(int32_t width) noexcept
+{
+  return static_cast<int16_t>(std::min<int32_t>(std::max<int32_t>(width, 0), INT16_MAX));
+}
+
+// Left end of a line of width in box.
+int32_t aligned_line_x(Rect box, int32_t width, TextAlign align) noexcept
+{
+  switch (align)
+  {
+    case TextAlign::CENTER:
+      return box.x + (static_cast<int32_t>(box.w) - width) / 2;
+    case TextAlign::RIGHT:
+      return box.x + static_cast<int32_t>(box.w) - width;
+    case TextAlign::LEFT:
+    default:
+      return box.x;
+  }
+}
+
+}  // namespace
+
+void DirtyRegion::Clear() noexcept { count_ = 0; }
+
+void DirtyRegion::Add(Rect rect) noexcept
+{
+  if (rect_empty(rect))
+  {
+    return;
+  }
+
+  // Absorb every rect the new one touches; the grown rect may then reach others.
+  uint8_t index = 0;
+  while (index < count_)
+  {
+    if (rects_touch(rects_[index], rect))
+    {
+      rect = union_rect(rects_[index], rect);
+      Remove(index);
+      index = 0;
+      continue;
+    }
+    ++index;
+  }
+
+  rects_[count_] = rect;
+  ++count_;
+  ReduceTo(MAX_RECTS);
+}
+
+void DirtyRegion::ReduceTo(uint8_t max_rects) noexcept
+{
+  const uint8_t LIMIT = (max_rects == 0) ? 1 : max_rects;
+  while (count_ > LIMIT)
+  {
+    uint8_t best_a = 0;
+    uint8_t best_b = 1;
+    int64_t best_cost = merge_cost(rects_[0], rects_[1]);
+    for (uint8_t a = 0; a < count_; ++a)
+    {
+      for (uint8_t b = static_cast<uint8_t>(a + 1); b < count_; ++b)
+      {
+        const int64_t COST = merge_cost(rects_[a], rects_[b]);
+        if (COST < best_cost)
+        {
+          best_cost = COST;
+          best_a = a;
+          best_b = b;
+        }
+      }
+    }
+    rects_[best_a] = union_rect(rects_[best_a], rects_[best_b]);
+    Remove(best_b);
+  }
+}
+
+Rect DirtyRegion::Bounds() const noexcept
+{
+  Rect bounds{};
+  for (uint8_t i = 0; i < count_; ++i)
+  {
+    bounds = union_rect(bounds, rects_[i]);
+  }
+  return bounds;
+}
+
+void DirtyRegion::Remove(uint8_t index) noexcept
+{
+  --count_;
+  rects_[index] = rects_[count_];
+}
+
+void PageDirtyMap::Clear() noexcept { spans_.fill(PageSpan{}); }
+
+void PageDirtyMap::Add(Rect rect) noexcept
+{
+  if (rect_empty(rect) || rect.x < 0 || rect.y < 0)
+  {
+    return;
+  }
+
+  const int32_t FIRST_PAGE = rect.y / PAGE_ROWS;
+  const int32_t LAST_PAGE = std::min<int32_t>(
+      (rect.y + static_cast<int32_t>(rect.h) - 1) / PAGE_ROWS, MAX_PAGES - 1);
+  const uint16_t X_BEGIN = static_cast<uint16_t>(rect.x);
+  const uint16_t X_END = static_cast<uint16_t>(rect.x + static_cast<int32_t>(rect.w));
+  for (int32_t page = FIRST_PAGE; page <= LAST_PAGE; ++page)
+  {
+    PageSpan& span = spans_[static_cast<std::size_t>(page)];
+    if (span.x_end <= span.x_begin)
+    {
+      span = PageSpan{X_BEGIN, X_END};
+      continue;
+    }
+    span.x_begin = std::min(span.x_begin, X_BEGIN);
+    span.x_end = std::max(span.x_end, X_END);
+  }
+}
+
+Point text_baseline(Point top_left, const TextStyle& style) noexcept
+{
+  if (style.font == nullptr)
+  {
+    return top_left;
+  }
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  return Point{
+      top_left.x,
+      static_cast<int16_t>(top_left.y + font_ascent(*style.font) * SCALE_Y),
+  };
+}
+
+Rect text_bounds(Point baseline_left, const char* text, const TextStyle& style) noexcept
+{
+  return text_span_bounds(baseline_left, text, nullptr, style);
+}
+
+uint16_t text_line_pitch(const TextStyle& style) noexcept
+{
+  if (style.font == nullptr)
+  {
+    return 0;
+  }
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  return static_cast<uint16_t>(text_line_pitch(*style.font, SCALE_Y));
+}
+
+Size measure_text(const char* text, const TextStyle& style) noexcept
+{
+  if (text == nullptr || style.font == nullptr)
+  {
+    return Size{};
+  }
+
+  const uint8_t SCALE_X = (style.scale_x == 0) ? 1 : style.scale_x;
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  int32_t width = 0;
+  uint32_t lines = 1;
+  const char* p = text;
+  while (true)
+  {
+    width = std::max(width, line_advance(*style.font, p, SCALE_X, style.letter_spacing));
+    if (*p == '\0')
+    {
+      break;
+    }
+    ++p;
+    ++lines;
+  }
+  const int64_t HEIGHT =
+      static_cast<int64_t>(lines) * text_line_pitch(*style.font, SCALE_Y) - 1;
+  return Size{static_cast<uint16_t>(clamp_text_width(width)),
+              static_cast<uint16_t>(std::min<int64_t>(HEIGHT, UINT16_MAX))};
+}
+
+uint16_t layout_text(const char* text, int16_t max_width, const TextStyle& style,
+                     TextLine* lines, uint16_t capacity) noexcept
+{
+  if (text == nullptr || style.font == nullptr)
+  {
+    return 0;
+  }
+
+  const Font& font = *style.font;
+  const uint8_t SCALE_X = (style.scale_x == 0) ? 1 : style.scale_x;
+  uint16_t count = 0;
+  auto emit = [&](const char* begin, const char* end, int32_t width)
+  {
+    if (lines != nullptr && count < capacity)
+    {
+      lines[count] = TextLine{begin, static_cast<uint16_t>(end - begin),
+                              clamp_text_width(width)};
+    }
+    if (count < UINT16_MAX)
+    {
+      ++count;
+    }
+  };
+
+  const char* p = text;
+  while (true)
+  {
+    const char* line_begin = p;
+    const char* space = nullptr;  // First space of the last run of spaces.
+    int32_t space_width = 0;
+    int32_t pen = 0;
+    int32_t width = 0;
+    while (true)
+    {
+      const char* at = p;
+      if (*p == '\0')
+      {
+        emit(line_begin, p, width);
+        return count;
+      }
+      const uint32_t CODEPOINT = utf8_next(p);
+      if (CODEPOINT == '\n')
+      {
+        emit(line_begin, at, width);
+        break;
+      }
+      if (CODEPOINT == ' ' && (at == line_begin || at[-1] != ' '))
+      {
+        space = at;
+        space_width = width;
+      }
+
+      const int32_t ADVANCE = place_glyph(font, CODEPOINT, SCALE_X, 1).advance;
+      if (at != line_begin && pen + ADVANCE > max_width)
+      {
+        // Wrap at the last space after a word, else before the glyph that overflows.
+        if (space != nullptr && space != line_begin)
+        {
+          emit(line_begin, space, space_width);
+          p = space;
+        }
+        else
+        {
+          emit(line_begin, at, width);
+          p = at;
+        }
+        while (*p == ' ')
+        {
+          ++p;
+        }
+        if (*p == '\0')
+        {
+          return count;
+        }
+        break;
+      }
+      width = pen + ADVANCE;
+      pen = width + style.letter_spacing;
+    }
+  }
+}
+
+Rect text_lines_bounds(Rect box, const TextLine* lines, uint16_t count,
+                       const TextStyle& style, TextAlign align) noexcept
 {
-  if (font.ascent == 0)
+  if (lines == nullptr || style.font == nullptr)
   {
-    return static_cast<int32_t>(font.glyph_height);
+    return Rect{};
   }
-  return static_cast<int32_t>(font.ascent);
-}
 
-int32_t font_descent(const Font& font) noexcept
-{
-  return static_cast<int32_t>(font.descent);
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  const int32_t LINE_PITCH = text_line_pitch(*style.font, SCALE_Y);
+  const int32_t BOTTOM = box.y + static_cast<int32_t>(box.h);
+  Rect bounds{};
+  int32_t top = box.y;
+  for (uint16_t i = 0; i < count && top < BOTTOM; ++i, top += LINE_PITCH)
+  {
+    const TextLine& LINE = lines[i];
+    const Point TOP_LEFT{static_cast<int16_t>(aligned_line_x(box, LINE.width, align)),
+                         static_cast<int16_t>(top)};
+    const Rect LINE_BOUNDS = text_span_bounds(text_baseline(TOP_LEFT, style), LINE.text,
+                                              LINE.text + LINE.length, style);
+    bounds = union_rect(bounds, LINE_BOUNDS);
+  }
+  return bounds;
 }
 
-int32_t font_line_height(const Font& font) noexcept
+void diff_frames(const uint8_t* current, const uint8_t* previous, Size size,
+                 uint16_t stride_bytes, PixelLayout layout, Rect window,
+                 DirtyRegion& region, PageDirtyMap* pages) noexcept
 {
-  const int32_t LINE_HEIGHT = font_ascent(font) + font_descent(font);
-  if (LINE_HEIGHT <= 0)
+  const Rect CLIPPED = intersect_rect(window, Rect{0, 0, size.w, size.h});
+  if (rect_empty(CLIPPED))
   {
-    return static_cast<int32_t>(font.glyph_height);
+    return;
   }
-  return LINE_HEIGHT;
+
+  const ByteWindow BYTES = layout_byte_window(CLIPPED, layout);
+  const int32_t CLIP_X_END = CLIPPED.x + static_cast<int32_t>(CLIPPED.w);
+  const int32_t CLIP_Y_END = CLIPPED.y + static_cast<int32_t>(CLIPPED.h);
+
+  // Changed rows are gathered into one rect per 8-row page.
+  int32_t page = -1;
+  int32_t x_begin = 0;
+  int32_t x_end = 0;
+  int32_t y_begin = 0;
+  int32_t y_end = 0;
+  auto flush = [&]()
+  {
+    if (page < 0)
+    {
+      return;
+    }
+    const Rect CHANGED{
+        static_cast<int16_t>(x_begin),
+        static_cast<int16_t>(y_begin),
+        static_cast<uint16_t>(x_end - x_begin),
+        static_cast<uint16_t>(y_end - y_begin),
+    };
+    region.Add(CHANGED);
+    if (pages != nullptr)
+    {
+      pages->Add(CHANGED);
+    }
+  };
+
+  for (uint16_t line = BYTES.line_begin; line < BYTES.line_end; ++line)
+  {
+    const std::size_t OFFSET = static_cast<std::size_t>(line) * stride_bytes;
+    const uint8_t* cur = current + OFFSET;
+    const uint8_t* prev = previous + OFFSET;
+    const std::size_t FIRST =
+        first_diff_byte(cur, prev, BYTES.byte_begin, BYTES.byte_end);
+    if (FIRST == BYTES.byte_end)
+    {
+      continue;
+    }
+    const std::size_t LAST = last_diff_byte(cur, prev, FIRST, BYTES.byte_end) - 1U;
+
+    int32_t row_x_begin = 0;
+    int32_t row_x_end = 0;
+    int32_t row_y_begin = line;
+    int32_t row_y_end = line + 1;
+    if (layout == PixelLayout::VERTICAL_PAGE)
+    {
+      const uint8_t BITS = diff_bits(cur, prev, FIRST, LAST + 1U);
+      row_x_begin = static_cast<int32_t>(FIRST);
+      row_x_end = static_cast<int32_t>(LAST) + 1;
+      row_y_begin = line * 8 + lowest_bit(BITS);
+      row_y_end = line * 8 + highest_bit(BITS) + 1;
+    }
+    else
+    {
+      const uint8_t HEAD = static_cast<uint8_t>(cur[FIRST] ^ prev[FIRST]);
+      const uint8_t TAIL = static_cast<uint8_t>(cur[LAST] ^ prev[LAST]);
+      const bool MSB_FIRST = (layout == PixelLayout::ROW_MAJOR_MSB);
+      row_x_begin = static_cast<int32_t>(FIRST) * 8 +
+                    (MSB_FIRST ? 7 - highest_bit(HEAD) : lowest_bit(HEAD));
+      row_x_end = static_cast<int32_t>(LAST) * 8 +
+                  (MSB_FIRST ? 7 - lowest_bit(TAIL) : highest_bit(TAIL)) + 1;
+    }
+
+    row_x_begin = std::max<int32_t>(row_x_begin, CLIPPED.x);
+    row_x_end = std::min<int32_t>(row_x_end, CLIP_X_END);
+    row_y_begin = std::max<int32_t>(row_y_begin, CLIPPED.y);
+    row_y_end = std::min<int32_t>(row_y_end, CLIP_Y_END);
+    if (row_x_end <= row_x_begin || row_y_end <= row_y_begin)
+    {
+      continue;
+    }
+
+    const int32_t ROW_PAGE = row_y_begin / PageDirtyMap::PAGE_ROWS;
+    if (ROW_PAGE != page)
+    {
+      flush();
+      page = ROW_PAGE;
+      x_begin = row_x_begin;
+      x_end = row_x_end;
+      y_begin = row_y_begin;
+      y_end = row_y_end;
+      continue;
+    }
+    x_begin = std::min(x_begin, row_x_begin);
+    x_end = std::max(x_end, row_x_end);
+    y_end = row_y_end;
+  }
+  flush();
 }
 
-}  // namespace
+void Surface::Bind(uint8_t* bits, Size size, uint16_t stride_bytes,
+                   PixelLayout layout) noexcept
+{
+  BindBand(bits, size, 0, size.h, stride_bytes, layout);
+}
 
-void Surface::Bind(uint8_t* bits, Size size, uint16_t stride_bytes) noexcept
+void Surface::BindBand(uint8_t* bits, Size size, uint16_t first_row, uint16_t row_count,
+                       uint16_t stride_bytes, PixelLayout layout) noexcept
 {
   bits_ = bits;
   size_ = size;
-  stride_bytes_ = (stride_bytes == 0) ? default_stride(size) : stride_bytes;
+  layout_ = layout;
+  stride_bytes_ =
+      (stride_bytes == 0) ? layout_default_stride(size.w, layout) : stride_bytes;
+  band_y_ = std::min(first_row, size.h);
+  band_rows_ = std::min<uint16_t>(row_count, static_cast<uint16_t>(size.h - band_y_));
   ResetClip();
   ClearDirtyRect();
 }
 
-Size Surface::GetSize() const noexcept { return size_; }
+void Surface::SetRotation(Rotation rotation) noexcept
+{
+  rotation_ = rotation;
+  ResetClip();
+}
+
+Rotation Surface::GetRotation() const noexcept { return rotation_; }
+
+Size Surface::GetSize() const noexcept
+{
+  if (rotation_ == Rotation::R90 || rotation_ == Rotation::R270)
+  {
+    return Size{size_.h, size_.w};
+  }
+  return size_;
+}
+
+Rect Surface::GetBand() const noexcept { return DeviceBounds(); }
 
 uint16_t Surface::GetStrideBytes() const noexcept { return stride_bytes_; }
 
+PixelLayout Surface::GetLayout() const noexcept { return layout_; }
+
 void Surface::Clear(Color color) noexcept
 {
-  if (bits_ == nullptr || size_.w == 0 || size_.h == 0 || stride_bytes_ == 0)
+  if (bits_ == nullptr || size_.w == 0 || band_rows_ == 0 || stride_bytes_ == 0)
   {
     return;
   }
 
   const std::size_t BYTES =
-      static_cast<std::size_t>(stride_bytes_) * static_cast<std::size_t>(size_.h);
+      static_cast<std::size_t>(stride_bytes_) *
+      static_cast<std::size_t>(layout_line_count(band_rows_, layout_));
   const uint8_t FILL = (color == Color::WHITE) ? 0xFF : 0x00;
   std::memset(bits_, FILL, BYTES);
   MarkDirty(Bounds());
@@ -126,10 +1853,7 @@ void Surface::DrawHLine(Point point, int16_t length, Color color,
     return;
   }
 
-  for (int32_t cx = rect.x; cx < rect.x + static_cast<int32_t>(rect.w); ++cx)
-  {
-    PlotUnchecked(static_cast<int16_t>(cx), rect.y, color, raster_op);
-  }
+  FillRectUnchecked(rect, color, raster_op);
   MarkDirty(rect);
 }
 
@@ -153,177 +1877,627 @@ void Surface::DrawVLine(Point point, int16_t length, Color color,
     return;
   }
 
-  Rect rect{
-      point.x,
-      static_cast<int16_t>(y),
-      1,
-      static_cast<uint16_t>(span),
-  };
-  rect = intersect_rect(rect, clip_);
+  Rect rect{
+      point.x,
+      static_cast<int16_t>(y),
+      1,
+      static_cast<uint16_t>(span),
+  };
+  rect = intersect_rect(rect, clip_);
+  if (rect_empty(rect))
+  {
+    return;
+  }
+
+  FillRectUnchecked(rect, color, raster_op);
+  MarkDirty(rect);
+}
+
+void Surface::DrawLine(Point p0, Point p1, Color color, RasterOp raster_op) noexcept
+{
+  if (bits_ == nullptr)
+  {
+    return;
+  }
+  const Rect DRAWN = PlotLine(p0, p1, false, color, raster_op);
+  if (!rect_empty(DRAWN))
+  {
+    MarkDirty(DRAWN);
+  }
+}
+
+Rect Surface::PlotLine(Point p0, Point p1, bool skip_first, Color color,
+                       RasterOp raster_op) noexcept
+{
+  const int32_t DX = std::abs(p1.x - p0.x);
+  const int32_t DY = std::abs(p1.y - p0.y);
+  const Rect BOX{
+      std::min(p0.x, p1.x),
+      std::min(p0.y, p1.y),
+      static_cast<uint16_t>(std::min<int32_t>(DX + 1, UINT16_MAX)),
+      static_cast<uint16_t>(std::min<int32_t>(DY + 1, UINT16_MAX)),
+  };
+  const Rect VISIBLE = intersect_rect(BOX, clip_);
+  if (rect_empty(VISIBLE))
+  {
+    return Rect{};
+  }
+  if (DX == 0 || DY == 0)
+  {
+    Rect span = BOX;
+    if (skip_first)
+    {
+      // Drop the p0 end of the span.
+      uint16_t& length = (DX != 0) ? span.w : span.h;
+      int16_t& begin = (DX != 0) ? span.x : span.y;
+      if (length <= 1U)
+      {
+        return Rect{};
+      }
+      --length;
+      if ((DX != 0) ? (p0.x < p1.x) : (p0.y < p1.y))
+      {
+        ++begin;
+      }
+    }
+    span = intersect_rect(span, clip_);
+    if (!rect_empty(span))
+    {
+      FillRectUnchecked(span, color, raster_op);
+    }
+    return span;
+  }
+
+  // Step i moves one pixel along the major axis and
+  // floor((2 * i * MINOR + MAJOR) / (2 * MAJOR)) pixels along the minor one, which is
+  // the pixel set of the classic Bresenham walk. The clip turns into a range of i.
+  const bool X_MAJOR = DX >= DY;
+  const int32_t MAJOR = X_MAJOR ? DX : DY;
+  const int32_t MINOR = X_MAJOR ? DY : DX;
+  const int32_t MAJOR_0 = X_MAJOR ? p0.x : p0.y;
+  const int32_t MINOR_0 = X_MAJOR ? p0.y : p0.x;
+  const int32_t MAJOR_STEP = ((X_MAJOR ? p1.x - p0.x : p1.y - p0.y) > 0) ? 1 : -1;
+  const int32_t MINOR_STEP = ((X_MAJOR ? p1.y - p0.y : p1.x - p0.x) > 0) ? 1 : -1;
+  const int64_t TWO_MAJOR = 2 * static_cast<int64_t>(MAJOR);
+  const int64_t TWO_MINOR = 2 * static_cast<int64_t>(MINOR);
+
+  int64_t first = skip_first ? 1 : 0;
+  int64_t last = MAJOR;
+  if (VISIBLE.w != BOX.w || VISIBLE.h != BOX.h)
+  {
+    // Offsets from the start, in walking direction, that stay inside the clip.
+    const auto OFFSETS = [](int32_t begin, int32_t step, int32_t lo, int32_t hi,
+                            int64_t& from, int64_t& to)
+    {
+      if (step > 0)
+      {
+        from = static_cast<int64_t>(lo) - begin;
+        to = static_cast<int64_t>(hi) - begin;
+      }
+      else
+      {
+        from = static_cast<int64_t>(begin) - hi;
+        to = static_cast<int64_t>(begin) - lo;
+      }
+    };
+    const int32_t CLIP_X_END = clip_.x + static_cast<int32_t>(clip_.w) - 1;
+    const int32_t CLIP_Y_END = clip_.y + static_cast<int32_t>(clip_.h) - 1;
+    int64_t major_from = 0;
+    int64_t major_to = 0;
+    int64_t minor_from = 0;
+    int64_t minor_to = 0;
+    if (X_MAJOR)
+    {
+      OFFSETS(MAJOR_0, MAJOR_STEP, clip_.x, CLIP_X_END, major_from, major_to);
+      OFFSETS(MINOR_0, MINOR_STEP, clip_.y, CLIP_Y_END, minor_from, minor_to);
+    }
+    else
+    {
+      OFFSETS(MAJOR_0, MAJOR_STEP, clip_.y, CLIP_Y_END, major_from, major_to);
+      OFFSETS(MINOR_0, MINOR_STEP, clip_.x, CLIP_X_END, minor_from, minor_to);
+    }
+    first = std::max(first, major_from);
+    last = std::min(last, major_to);
+    // minor(i) >= F  <=>  i >= ceil((2 * MAJOR * F - MAJOR) / (2 * MINOR)),
+    // minor(i) <= F  <=>  i <= floor((2 * MAJOR * F + MAJOR - 1) / (2 * MINOR)).
+    if (minor_from > 0)
+    {
+      const int64_t NUM = TWO_MAJOR * minor_from - MAJOR;
+      first = std::max(first, (NUM + TWO_MINOR - 1) / TWO_MINOR);
+    }
+    if (minor_to < 0)
+    {
+      return Rect{};
+    }
+    last = std::min(last, (TWO_MAJOR * minor_to + MAJOR - 1) / TWO_MINOR);
+  }
+  if (first > last)
+  {
+    return Rect{};
+  }
+
+  const int64_t START = TWO_MINOR * first + MAJOR;
+  int32_t minor = static_cast<int32_t>(START / TWO_MAJOR);
+  int32_t remainder = static_cast<int32_t>(START % TWO_MAJOR);
+  int32_t major = static_cast<int32_t>(first);
+  const int32_t LAST = static_cast<int32_t>(last);
+  const int32_t MINOR_FIRST = minor;
+  with_plotter(bits_, stride_bytes_, layout_, rotation_, size_, band_y_,
+               resolve_span_op(color, raster_op),
+               [&](const auto& plot)
+               {
+                 while (true)
+                 {
+                   const int32_t A = MAJOR_0 + MAJOR_STEP * major;
+                   const int32_t B = MINOR_0 + MINOR_STEP * minor;
+                   plot(X_MAJOR ? A : B, X_MAJOR ? B : A);
+                   if (major == LAST)
+                   {
+                     break;
+                   }
+                   ++major;
+                   remainder += static_cast<int32_t>(TWO_MINOR);
+                   if (remainder >= TWO_MAJOR)
+                   {
+                     remainder -= static_cast<int32_t>(TWO_MAJOR);
+                     ++minor;
+                   }
+                 }
+               });
+
+  // Box of the pixels actually drawn.
+  const int32_t MAJOR_A = MAJOR_0 + MAJOR_STEP * static_cast<int32_t>(first);
+  const int32_t MAJOR_B = MAJOR_0 + MAJOR_STEP * LAST;
+  const int32_t MINOR_A = MINOR_0 + MINOR_STEP * MINOR_FIRST;
+  const int32_t MINOR_B = MINOR_0 + MINOR_STEP * minor;
+  const Rect MAJOR_SPAN{static_cast<int16_t>(std::min(MAJOR_A, MAJOR_B)), 0,
+                        static_cast<uint16_t>(std::abs(MAJOR_B - MAJOR_A) + 1), 1};
+  const Rect MINOR_SPAN{static_cast<int16_t>(std::min(MINOR_A, MINOR_B)), 0,
+                        static_cast<uint16_t>(std::abs(MINOR_B - MINOR_A) + 1), 1};
+  return X_MAJOR ? Rect{MAJOR_SPAN.x, MINOR_SPAN.x, MAJOR_SPAN.w, MINOR_SPAN.w}
+                 : Rect{MINOR_SPAN.x, MAJOR_SPAN.x, MINOR_SPAN.w, MAJOR_SPAN.w};
+}
+
+void Surface::DrawRect(Rect rect, Color color, RasterOp raster_op) noexcept
+{
+  if (rect_empty(rect))
+  {
+    return;
+  }
+
+  DrawHLine(Point{rect.x, rect.y}, static_cast<int16_t>(rect.w), color, raster_op);
+  if (rect.h > 1)
+  {
+    DrawHLine(
+        Point{rect.x, static_cast<int16_t>(rect.y + static_cast<int32_t>(rect.h) - 1)},
+        static_cast<int16_t>(rect.w), color, raster_op);
+  }
+  if (rect.h > 2)
+  {
+    DrawVLine(Point{rect.x, static_cast<int16_t>(rect.y + 1)},
+              static_cast<int16_t>(rect.h - 2), color, raster_op);
+    if (rect.w > 1)
+    {
+      DrawVLine(Point{static_cast<int16_t>(rect.x + static_cast<int32_t>(rect.w) - 1),
+                      static_cast<int16_t>(rect.y + 1)},
+                static_cast<int16_t>(rect.h - 2), color, raster_op);
+    }
+  }
+}
+
+void Surface::FillRect(Rect rect, Color color, RasterOp raster_op) noexcept
+{
+  rect = intersect_rect(rect, clip_);
+  if (rect_empty(rect))
+  {
+    return;
+  }
+
+  if (bits_ == nullptr)
+  {
+    return;
+  }
+
+  FillRectUnchecked(rect, color, raster_op);
+  MarkDirty(rect);
+}
+
+void Surface::CopyRect(Rect src, Point dst_top_left) noexcept
+{
+  if (bits_ == nullptr || stride_bytes_ == 0)
+  {
+    return;
+  }
+
+  // Clip the destination, pull the source back to the bound rows, then match them up.
+  const int32_t DX = static_cast<int32_t>(dst_top_left.x) - src.x;
+  const int32_t DY = static_cast<int32_t>(dst_top_left.y) - src.y;
+  const Rect VISIBLE = intersect_rect(offset_rect(src, DX, DY), clip_);
+  const Rect SOURCE = intersect_rect(offset_rect(VISIBLE, -DX, -DY), Bounds());
+  const Rect TARGET = offset_rect(SOURCE, DX, DY);
+  if (rect_empty(TARGET) || (DX == 0 && DY == 0))
+  {
+    return;
+  }
+
+  // Rotation is rigid, so the two rects stay the same size on the panel.
+  Rect from = rotate_rect(SOURCE, rotation_, size_);
+  Rect to = rotate_rect(TARGET, rotation_, size_);
+  from.y = static_cast<int16_t>(from.y - static_cast<int32_t>(band_y_));
+  to.y = static_cast<int16_t>(to.y - static_cast<int32_t>(band_y_));
+  with_layout(layout_,
+              [&](auto layout)
+              {
+                copy_rect<decltype(layout)>(bits_, stride_bytes_, from,
+                                            Point{to.x, to.y});
+              });
+  MarkDirty(TARGET);
+}
+
+void Surface::ScrollRect(Rect rect, int16_t dx, int16_t dy, Color fill) noexcept
+{
+  const Rect AREA = intersect_rect(rect, clip_);
+  if (bits_ == nullptr || rect_empty(AREA) || (dx == 0 && dy == 0))
+  {
+    return;
+  }
+
+  const int32_t W = AREA.w;
+  const int32_t H = AREA.h;
+  const int32_t COLS = std::min<int32_t>(std::abs(static_cast<int32_t>(dx)), W);
+  const int32_t ROWS = std::min<int32_t>(std::abs(static_cast<int32_t>(dy)), H);
+  const Rect SAVED_CLIP = clip_;
+  clip_ = AREA;
+  if (COLS < W && ROWS < H)
+  {
+    CopyRect(AREA, Point{static_cast<int16_t>(AREA.x + dx),
+                         static_cast<int16_t>(AREA.y + dy)});
+  }
+
+  // Uncovered columns, then uncovered rows.
+  if (COLS > 0)
+  {
+    FillRect(Rect{static_cast<int16_t>(dx > 0 ? AREA.x : AREA.x + W - COLS), AREA.y,
+                  static_cast<uint16_t>(COLS), AREA.h},
+             fill);
+  }
+  if (ROWS > 0)
+  {
+    FillRect(Rect{AREA.x, static_cast<int16_t>(dy > 0 ? AREA.y : AREA.y + H - ROWS),
+                  AREA.w, static_cast<uint16_t>(ROWS)},
+             fill);
+  }
+  clip_ = SAVED_CLIP;
+}
+
+void Surface::DrawPolyline(const Point* points, uint16_t count, Color color,
+                           RasterOp raster_op) noexcept
+{
+  if (bits_ == nullptr || points == nullptr || count == 0)
+  {
+    return;
+  }
+
+  Rect drawn = PlotLine(points[0], points[0], false, color, raster_op);
+  for (uint16_t i = 1; i < count; ++i)
+  {
+    const Rect SEGMENT = PlotLine(points[i - 1U], points[i], true, color, raster_op);
+    drawn = union_rect(drawn, SEGMENT);
+  }
+  if (!rect_empty(drawn))
+  {
+    MarkDirty(drawn);
+  }
+}
+
+void Surface::DrawPixels(const Point* points, uint16_t count, Color color,
+                         RasterOp raster_op) noexcept
+{
+  if (bits_ == nullptr || points == nullptr)
+  {
+    return;
+  }
+
+  int32_t x_min = INT32_MAX;
+  int32_t y_min = INT32_MAX;
+  int32_t x_max = INT32_MIN;
+  int32_t y_max = INT32_MIN;
+  with_plotter(bits_, stride_bytes_, layout_, rotation_, size_, band_y_,
+               resolve_span_op(color, raster_op),
+               [&](const auto& plot)
+               {
+                 for (uint16_t i = 0; i < count; ++i)
+                 {
+                   const Point POINT = points[i];
+                   if (!InClip(POINT))
+                   {
+                     continue;
+                   }
+                   plot(POINT.x, POINT.y);
+                   x_min = std::min<int32_t>(x_min, POINT.x);
+                   y_min = std::min<int32_t>(y_min, POINT.y);
+                   x_max = std::max<int32_t>(x_max, POINT.x);
+                   y_max = std::max<int32_t>(y_max, POINT.y);
+                 }
+               });
+  if (x_max >= x_min)
+  {
+    MarkDirty(Rect{static_cast<int16_t>(x_min), static_cast<int16_t>(y_min),
+                   static_cast<uint16_t>(x_max - x_min + 1),
+                   static_cast<uint16_t>(y_max - y_min + 1)});
+  }
+}
+
+void Surface::FillRects(const Rect* rects, uint16_t count, Color color,
+                        RasterOp raster_op) noexcept
+{
+  if (bits_ == nullptr || rects == nullptr)
+  {
+    return;
+  }
+
+  // Merged locally so the surface region and page map are updated once per result.
+  DirtyRegion drawn{};
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const Rect RECT = intersect_rect(rects[i], clip_);
+    if (rect_empty(RECT))
+    {
+      continue;
+    }
+    FillRectUnchecked(RECT, color, raster_op);
+    drawn.Add(RECT);
+  }
+  for (uint8_t i = 0; i < drawn.Count(); ++i)
+  {
+    MarkDirty(drawn.Rects()[i]);
+  }
+}
+
+void Surface::DrawHistogram(Rect area, const uint8_t* heights, uint16_t count,
+                            uint8_t bar_width, Color color, RasterOp raster_op) noexcept
+{
+  const Rect VISIBLE = intersect_rect(area, clip_);
+  if (bits_ == nullptr || heights == nullptr || bar_width == 0 || rect_empty(VISIBLE))
+  {
+    return;
+  }
+
+  const int32_t AREA_RIGHT = area.x + static_cast<int32_t>(area.w);
+  const int32_t BOTTOM = area.y + static_cast<int32_t>(area.h);
+  const uint16_t BARS = static_cast<uint16_t>(
+      std::min<uint32_t>(count, (area.w + bar_width - 1U) / bar_width));
+  Rect drawn{};
+  uint16_t i = 0;
+  while (i < BARS)
+  {
+    // Neighbouring bars of equal height are filled as one rect.
+    const uint16_t HEIGHT = std::min<uint16_t>(heights[i], area.h);
+    uint16_t end = static_cast<uint16_t>(i + 1U);
+    while (end < BARS && std::min<uint16_t>(heights[end], area.h) == HEIGHT)
+    {
+      ++end;
+    }
+    if (HEIGHT != 0U)
+    {
+      const int32_t X = area.x + static_cast<int32_t>(i) * bar_width;
+      const int32_t X_END =
+          std::min(AREA_RIGHT, area.x + static_cast<int32_t>(end) * bar_width);
+      const Rect BAR = intersect_rect(
+          Rect{static_cast<int16_t>(X), static_cast<int16_t>(BOTTOM - HEIGHT),
+               static_cast<uint16_t>(X_END - X), HEIGHT},
+          VISIBLE);
+      if (!rect_empty(BAR))
+      {
+        FillRectUnchecked(BAR, color, raster_op);
+        drawn = union_rect(drawn, BAR);
+      }
+    }
+    i = end;
+  }
+  if (!rect_empty(drawn))
+  {
+    MarkDirty(drawn);
+  }
+}
+
+void Surface::DrawCircle(Point center, uint8_t radius, Color color,
+                         RasterOp raster_op) noexcept
+{
+  DrawRound(Rect{center.x, center.y, 1, 1}, radius, radius, color, raster_op);
+}
+
+void Surface::FillCircle(Point center, uint8_t radius, Color color,
+                         RasterOp raster_op) noexcept
+{
+  FillRound(Rect{center.x, center.y, 1, 1}, radius, radius, color, raster_op);
+}
+
+void Surface::DrawEllipse(Point center, uint8_t radius_x, uint8_t radius_y, Color color,
+                          RasterOp raster_op) noexcept
+{
+  DrawRound(Rect{center.x, center.y, 1, 1}, radius_x, radius_y, color, raster_op);
+}
+
+void Surface::FillEllipse(Point center, uint8_t radius_x, uint8_t radius_y, Color color,
+                          RasterOp raster_op) noexcept
+{
+  FillRound(Rect{center.x, center.y, 1, 1}, radius_x, radius_y, color, raster_op);
+}
+
+void Surface::DrawRoundRect(Rect rect, uint8_t radius, Color color,
+                            RasterOp raster_op) noexcept
+{
   if (rect_empty(rect))
   {
     return;
   }
+  const uint8_t RADIUS = round_rect_radius(rect, radius);
+  DrawRound(round_rect_inner(rect, RADIUS), RADIUS, RADIUS, color, raster_op);
+}
 
-  for (int32_t cy = rect.y; cy < rect.y + static_cast<int32_t>(rect.h); ++cy)
+void Surface::FillRoundRect(Rect rect, uint8_t radius, Color color,
+                            RasterOp raster_op) noexcept
+{
+  if (rect_empty(rect))
   {
-    PlotUnchecked(rect.x, static_cast<int16_t>(cy), color, raster_op);
+    return;
   }
-  MarkDirty(rect);
+  const uint8_t RADIUS = round_rect_radius(rect, radius);
+  FillRound(round_rect_inner(rect, RADIUS), RADIUS, RADIUS, color, raster_op);
 }
 
-void Surface::DrawLine(Point p0, Point p1, Color color, RasterOp raster_op) noexcept
+void Surface::DrawBitmap(Point point, const uint8_t* bits, Size size, Color foreground,
+                         RasterOp raster_op) noexcept
 {
-  int32_t x0 = p0.x;
-  int32_t y0 = p0.y;
-  const int32_t X1 = p1.x;
-  const int32_t Y1 = p1.y;
-
-  const int32_t DX = std::abs(X1 - x0);
-  const int32_t SX = (x0 < X1) ? 1 : -1;
-  const int32_t DY = -std::abs(Y1 - y0);
-  const int32_t SY = (y0 < Y1) ? 1 : -1;
-  int32_t err = DX + DY;
-
-  while (true)
-  {
-    DrawPixel(Point{static_cast<int16_t>(x0), static_cast<int16_t>(y0)}, color,
-              raster_op);
-    if (x0 == X1 && y0 == Y1)
-    {
-      break;
-    }
-    const int32_t E2 = 2 * err;
-    if (E2 >= DY)
-    {
-      err += DY;
-      x0 += SX;
-    }
-    if (E2 <= DX)
-    {
-      err += DX;
-      y0 += SY;
-    }
-  }
+  BitmapStyle style{};
+  style.foreground = foreground;
+  style.raster_op = raster_op;
+  DrawBitmap(point, bits, size, style);
 }
 
-void Surface::DrawRect(Rect rect, Color color, RasterOp raster_op) noexcept
+void Surface::DrawBitmap(Point point, const uint8_t* bits, Size size,
+                         const BitmapStyle& style) noexcept
 {
-  if (rect_empty(rect))
+  if (bits_ == nullptr || bits == nullptr || size.w == 0 || size.h == 0)
   {
     return;
   }
 
-  DrawHLine(Point{rect.x, rect.y}, static_cast<int16_t>(rect.w), color, raster_op);
-  if (rect.h > 1)
+  const Rect CLIPPED = intersect_rect(Rect{point.x, point.y, size.w, size.h}, clip_);
+  if (rect_empty(CLIPPED))
   {
-    DrawHLine(
-        Point{rect.x, static_cast<int16_t>(rect.y + static_cast<int32_t>(rect.h) - 1)},
-        static_cast<int16_t>(rect.w), color, raster_op);
+    return;
   }
-  if (rect.h > 2)
+
+  const uint16_t SRC_STRIDE =
+      (style.stride_bytes == 0) ? default_stride(size) : style.stride_bytes;
+  BlitUnchecked(point, CLIPPED, BlitSource{bits, style.mask, SRC_STRIDE, 1, 1},
+                style.foreground, style.raster_op, style.mode);
+  MarkDirty(CLIPPED);
+}
+
+void Surface::DrawGray8(Point point, const uint8_t* gray, Size size,
+                        const GrayStyle& style) noexcept
+{
+  if (gray == nullptr)
   {
-    DrawVLine(Point{rect.x, static_cast<int16_t>(rect.y + 1)},
-              static_cast<int16_t>(rect.h - 2), color, raster_op);
-    if (rect.w > 1)
-    {
-      DrawVLine(Point{static_cast<int16_t>(rect.x + static_cast<int32_t>(rect.w) - 1),
-                      static_cast<int16_t>(rect.y + 1)},
-                static_cast<int16_t>(rect.h - 2), color, raster_op);
-    }
+    return;
   }
+  GrayImage image{gray, (style.stride_bytes == 0) ? size.w : style.stride_bytes};
+  DrawGray8(point, size, &gray_image_row, &image, style);
 }
 
-void Surface::FillRect(Rect rect, Color color, RasterOp raster_op) noexcept
+void Surface::DrawGray8(Point point, Size size, GrayRowFn row, void* context,
+                        const GrayStyle& style) noexcept
 {
-  rect = intersect_rect(rect, clip_);
-  if (rect_empty(rect))
+  if (bits_ == nullptr || row == nullptr || size.w == 0 || size.h == 0)
   {
     return;
   }
 
-  for (int32_t y = rect.y; y < rect.y + static_cast<int32_t>(rect.h); ++y)
+  const Rect CLIPPED = intersect_rect(Rect{point.x, point.y, size.w, size.h}, clip_);
+  if (rect_empty(CLIPPED))
   {
-    DrawHLine(Point{rect.x, static_cast<int16_t>(y)}, static_cast<int16_t>(rect.w), color,
-              raster_op);
+    return;
   }
-}
-
-void Surface::DrawCircle(Point center, uint8_t radius, Color color,
-                         RasterOp raster_op) noexcept
-{
-  int32_t x = radius;
-  int32_t y = 0;
-  int32_t err = 1 - x;
 
-  while (x >= y)
+  // Error runs through clipped pixels as well, so diffusion covers the whole width and
+  // the rows above the clip; the other modes only convert what is drawn.
+  const bool DIFFUSE = style.dither == DitherMode::FLOYD_STEINBERG &&
+                       style.errors != nullptr && style.error_count > size.w;
+  const int32_t VISIBLE_Y = CLIPPED.y - point.y;
+  const int32_t Y_END = VISIBLE_Y + static_cast<int32_t>(CLIPPED.h);
+  const int32_t CLIP_X_END = CLIPPED.x + static_cast<int32_t>(CLIPPED.w);
+  const int32_t X_BEGIN = DIFFUSE ? 0 : ((CLIPPED.x - point.x) & ~0x7);
+  const int32_t X_END = DIFFUSE ? size.w : CLIP_X_END - point.x;
+  ErrorDiffusion diffusion{style.errors};
+  if (DIFFUSE)
   {
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x + x), static_cast<int16_t>(center.y + y)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x + y), static_cast<int16_t>(center.y + x)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x - y), static_cast<int16_t>(center.y + x)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x - x), static_cast<int16_t>(center.y + y)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x - x), static_cast<int16_t>(center.y - y)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x - y), static_cast<int16_t>(center.y - x)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x + y), static_cast<int16_t>(center.y - x)},
-        color, raster_op);
-    DrawPixel(
-        Point{static_cast<int16_t>(center.x + x), static_cast<int16_t>(center.y - y)},
-        color, raster_op);
+    std::fill_n(style.errors, size.w + 1U, static_cast<int16_t>(0));
+  }
 
-    ++y;
-    if (err < 0)
+  std::array<uint8_t, GRAY_CHUNK_PIXELS / 8> packed{};
+  for (int32_t y = DIFFUSE ? 0 : VISIBLE_Y; y < Y_END; ++y)
+  {
+    const uint8_t* samples = row(context, static_cast<uint16_t>(y));
+    if (samples == nullptr)
     {
-      err += 2 * y + 1;
+      if (DIFFUSE)
+      {
+        diffusion.SkipRow(size.w);
+      }
+      continue;
     }
-    else
+    const uint8_t* thresholds =
+        (style.dither == DitherMode::THRESHOLD)
+            ? FLAT_THRESHOLDS.data()
+            : BAYER_THRESHOLDS[static_cast<std::size_t>(y & 0x7)].data();
+    for (int32_t begin = X_BEGIN; begin < X_END; begin += GRAY_CHUNK_PIXELS)
     {
-      --x;
-      err += 2 * (y - x + 1);
+      const int32_t END = std::min(begin + GRAY_CHUNK_PIXELS, X_END);
+      if (DIFFUSE)
+      {
+        diffusion.Pack(samples, begin, END, packed.data());
+      }
+      else
+      {
+        pack_ordered(samples, begin, END, thresholds, packed.data());
+      }
+
+      const int32_t SPAN_BEGIN = std::max<int32_t>(point.x + begin, CLIPPED.x);
+      const int32_t SPAN_END = std::min<int32_t>(point.x + END, CLIP_X_END);
+      if (y < VISIBLE_Y || SPAN_BEGIN >= SPAN_END)
+      {
+        continue;
+      }
+      const Point ORIGIN{static_cast<int16_t>(point.x + begin),
+                         static_cast<int16_t>(point.y + y)};
+      const Rect SPAN{static_cast<int16_t>(SPAN_BEGIN), ORIGIN.y,
+                      static_cast<uint16_t>(SPAN_END - SPAN_BEGIN), 1};
+      BlitUnchecked(ORIGIN, SPAN,
+                    BlitSource{packed.data(), nullptr,
+                               static_cast<uint16_t>(packed.size()), 1, 1},
+                    Color::WHITE, RasterOp::COPY, BitmapMode::OPAQUE);
+    }
+    if (DIFFUSE)
+    {
+      diffusion.EndRow(size.w);
     }
   }
+  MarkDirty(CLIPPED);
 }
 
-void Surface::DrawBitmap(Point point, const uint8_t* bits, Size size, Color foreground,
-                         RasterOp raster_op) noexcept
+void Surface::DrawText(Point baseline_left, const char* text,
+                       const TextStyle& style) noexcept
+{
+  DrawTextSpan(baseline_left, text, nullptr, style);
+}
+
+void Surface::DrawTextLines(Rect box, const TextLine* lines, uint16_t count,
+                            const TextStyle& style, TextAlign align) noexcept
 {
-  if (bits == nullptr || size.w == 0 || size.h == 0)
+  if (lines == nullptr || style.font == nullptr)
   {
     return;
   }
 
-  const uint16_t SRC_STRIDE = default_stride(size);
-  for (uint16_t y = 0; y < size.h; ++y)
+  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
+  const int32_t LINE_PITCH = text_line_pitch(*style.font, SCALE_Y);
+  const int32_t BOTTOM = box.y + static_cast<int32_t>(box.h);
+  int32_t top = box.y;
+  for (uint16_t i = 0; i < count && top < BOTTOM; ++i, top += LINE_PITCH)
   {
-    for (uint16_t x = 0; x < size.w; ++x)
-    {
-      const uint8_t BYTE = bits[static_cast<std::size_t>(y) * SRC_STRIDE +
-                                static_cast<std::size_t>(x / 8)];
-      const uint8_t MASK = static_cast<uint8_t>(0x80U >> (x & 0x7));
-      if ((BYTE & MASK) != 0U)
-      {
-        DrawPixel(
-            Point{static_cast<int16_t>(point.x + x), static_cast<int16_t>(point.y + y)},
-            foreground, raster_op);
-      }
-    }
+    const TextLine& LINE = lines[i];
+    const Point TOP_LEFT{static_cast<int16_t>(aligned_line_x(box, LINE.width, align)),
+                         static_cast<int16_t>(top)};
+    DrawTextSpan(text_baseline(TOP_LEFT, style), LINE.text, LINE.text + LINE.length,
+                 style);
   }
 }
 
-void Surface::DrawText(Point baseline_left, const char* text,
-                       const TextStyle& style) noexcept
+void Surface::DrawTextSpan(Point baseline_left, const char* text, const char* end,
+                           const TextStyle& style) noexcept
 {
   if (text == nullptr || style.font == nullptr)
   {
@@ -331,63 +2505,79 @@ void Surface::DrawText(Point baseline_left, const char* text,
   }
 
   const Font& font = *style.font;
-  if (font.glyphs == nullptr || font.glyph_width == 0 || font.glyph_height == 0 ||
-      font.last_char < font.first_char)
+  const bool RLE = font.format == FontFormat::RLE;
+  if (font.glyphs == nullptr ||
+      (font.ranges == nullptr && font.last_char < font.first_char) ||
+      (RLE ? font.glyph_table == nullptr
+           : (font.glyph_width == 0 || font.glyph_height == 0)))
+  {
+    return;
+  }
+
+  if (bits_ == nullptr)
   {
     return;
   }
 
   const uint8_t SCALE_X = (style.scale_x == 0) ? 1 : style.scale_x;
   const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
-  const uint16_t GLYPH_STRIDE = static_cast<uint16_t>(
-      ((font.glyph_width + 7) / 8) * static_cast<uint16_t>(font.glyph_height));
-  const int32_t ADVANCE =
-      static_cast<int32_t>(font.glyph_width) * SCALE_X + style.letter_spacing;
-  const int32_t ASCENT = font_ascent(font);
-  const int32_t LINE_HEIGHT = font_line_height(font);
+  const uint16_t ROW_BYTES = font_glyph_row_bytes(font);
+  const uint16_t CACHED_ROW_BYTES = static_cast<uint16_t>(
+      (static_cast<uint32_t>(font.glyph_width) * SCALE_X + 7U) / 8U);
+  const int32_t LINE_PITCH = text_line_pitch(font, SCALE_Y);
 
+  // Dirty marking is batched per text line.
+  Rect line_dirty{};
   int32_t cursor_x = baseline_left.x;
   int32_t baseline_y = baseline_left.y;
-  for (const char* p = text; *p != '\0'; ++p)
+  for (const char* p = text; p != end && *p != '\0';)
   {
-    if (*p == '\n')
+    const uint32_t CODEPOINT = utf8_next(p);
+    if (CODEPOINT == '\n')
     {
+      MarkDirty(line_dirty);
+      line_dirty = Rect{};
       cursor_x = baseline_left.x;
-      baseline_y += LINE_HEIGHT * SCALE_Y + 1;
+      baseline_y += LINE_PITCH;
       continue;
     }
 
-    const int32_t TOP_Y = baseline_y - ASCENT * SCALE_Y;
-    const uint8_t CH = static_cast<uint8_t>(*p);
-    if (CH >= font.first_char && CH <= font.last_char)
+    const GlyphPlacement PLACE = place_glyph(font, CODEPOINT, SCALE_X, SCALE_Y);
+    const Point ORIGIN{static_cast<int16_t>(cursor_x + PLACE.x_offset),
+                       static_cast<int16_t>(baseline_y + PLACE.top)};
+    const Rect CLIPPED =
+        intersect_rect(Rect{ORIGIN.x, ORIGIN.y, PLACE.w, PLACE.h}, clip_);
+    if (PLACE.present && !rect_empty(CLIPPED))
     {
-      const std::size_t GLYPH_INDEX = static_cast<std::size_t>(CH - font.first_char);
-      const uint8_t* glyph = font.glyphs + GLYPH_INDEX * GLYPH_STRIDE;
-
-      for (uint8_t gy = 0; gy < font.glyph_height; ++gy)
+      const uint16_t GLYPH_INDEX = PLACE.index;
+      const uint8_t* cached = nullptr;
+      if (!RLE && SCALE_X > 1 && style.glyph_cache != nullptr)
       {
-        for (uint8_t gx = 0; gx < font.glyph_width; ++gx)
-        {
-          const uint8_t BYTE =
-              glyph[static_cast<std::size_t>(gy) * ((font.glyph_width + 7) / 8) +
-                    (gx / 8)];
-          const uint8_t MASK = static_cast<uint8_t>(0x80U >> (gx & 0x7));
-          if ((BYTE & MASK) != 0U)
-          {
-            FillRect(
-                Rect{
-                    static_cast<int16_t>(cursor_x + static_cast<int32_t>(gx) * SCALE_X),
-                    static_cast<int16_t>(TOP_Y + static_cast<int32_t>(gy) * SCALE_Y),
-                    SCALE_X,
-                    SCALE_Y,
-                },
-                style.color, style.raster_op);
-          }
-        }
+        cached = style.glyph_cache->Lookup(font, GLYPH_INDEX, SCALE_X);
+      }
+      if (RLE)
+      {
+        BlitRleGlyph(ORIGIN, CLIPPED, font, font.glyph_table[GLYPH_INDEX], SCALE_X,
+                     SCALE_Y, style.color, style.raster_op);
+      }
+      else if (cached != nullptr)
+      {
+        BlitUnchecked(ORIGIN, CLIPPED,
+                      BlitSource{cached, nullptr, CACHED_ROW_BYTES, 1, SCALE_Y},
+                      style.color, style.raster_op, BitmapMode::TRANSPARENT);
+      }
+      else
+      {
+        BlitUnchecked(ORIGIN, CLIPPED,
+                      BlitSource{font_glyph_bits(font, GLYPH_INDEX), nullptr, ROW_BYTES,
+                                 SCALE_X, SCALE_Y},
+                      style.color, style.raster_op, BitmapMode::TRANSPARENT);
       }
+      line_dirty = union_rect(line_dirty, CLIPPED);
     }
-    cursor_x += ADVANCE;
+    cursor_x += PLACE.advance + style.letter_spacing;
   }
+  MarkDirty(line_dirty);
 }
 
 void Surface::DrawText(Point baseline_left, const char* text, const TextStyle& style,
@@ -401,19 +2591,7 @@ void Surface::DrawText(Point baseline_left, const char* text, const TextStyle& s
 void Surface::DrawTextTopLeft(Point top_left, const char* text,
                               const TextStyle& style) noexcept
 {
-  if (style.font == nullptr)
-  {
-    DrawText(top_left, text, style);
-    return;
-  }
-
-  const uint8_t SCALE_Y = (style.scale_y == 0) ? 1 : style.scale_y;
-  const int32_t ASCENT = font_ascent(*style.font);
-  const Point BASELINE_LEFT{
-      top_left.x,
-      static_cast<int16_t>(top_left.y + ASCENT * SCALE_Y),
-  };
-  DrawText(BASELINE_LEFT, text, style);
+  DrawText(text_baseline(top_left, style), text, style);
 }
 
 void Surface::DrawTextTopLeft(Point top_left, const char* text, const TextStyle& style,
@@ -424,13 +2602,45 @@ void Surface::DrawTextTopLeft(Point top_left, const char* text, const TextStyle&
   DrawTextTopLeft(top_left, text, override_style);
 }
 
-Rect Surface::GetDirtyRect() const noexcept { return dirty_; }
+Rect Surface::GetDirtyRect() const noexcept { return dirty_.Bounds(); }
 
-void Surface::ClearDirtyRect() noexcept { dirty_ = Rect{}; }
+const DirtyRegion& Surface::GetDirtyRegion() const noexcept { return dirty_; }
 
-void Surface::AddDirtyRect(Rect rect) noexcept { MarkDirty(rect); }
+void Surface::ClearDirtyRect() noexcept
+{
+  dirty_.Clear();
+  if (page_dirty_enabled_)
+  {
+    page_dirty_.Clear();
+  }
+}
+
+void Surface::EnablePageDirty(bool enable) noexcept
+{
+  page_dirty_enabled_ = enable;
+  page_dirty_.Clear();
+}
+
+bool Surface::IsPageDirtyEnabled() const noexcept { return page_dirty_enabled_; }
+
+const PageDirtyMap& Surface::GetPageDirty() const noexcept { return page_dirty_; }
+
+void Surface::AddDirtyRect(Rect rect) noexcept { MarkDeviceDirty(rect); }
+
+Rect Surface::ToDeviceRect(Rect rect) const noexcept
+{
+  return rotate_rect(intersect_rect(rect, Bounds()), rotation_, size_);
+}
+
+Rect Surface::Bounds() const noexcept
+{
+  return unrotate_rect(DeviceBounds(), rotation_, size_);
+}
 
-Rect Surface::Bounds() const noexcept { return bounds_rect(size_); }
+Rect Surface::DeviceBounds() const noexcept
+{
+  return Rect{0, static_cast<int16_t>(band_y_), size_.w, band_rows_};
+}
 
 bool Surface::InClip(Point point) const noexcept
 {
@@ -446,6 +2656,156 @@ bool Surface::InClip(Point point) const noexcept
   return true;
 }
 
+void Surface::DrawRound(Rect inner, uint8_t radius_x, uint8_t radius_y, Color color,
+                        RasterOp raster_op) noexcept
+{
+  const Rect BOX = round_box(inner, radius_x, radius_y);
+  const Rect VISIBLE = intersect_rect(BOX, clip_);
+  if (bits_ == nullptr || rect_empty(VISIBLE))
+  {
+    return;
+  }
+
+  // Only shapes that cross the clip edge test each pixel.
+  const bool INSIDE = VISIBLE.w == BOX.w && VISIBLE.h == BOX.h;
+  const int32_t LEFT = inner.x;
+  const int32_t RIGHT = inner.x + static_cast<int32_t>(inner.w) - 1;
+  const int32_t TOP = inner.y;
+  const int32_t BOTTOM = inner.y + static_cast<int32_t>(inner.h) - 1;
+  with_plotter(
+      bits_, stride_bytes_, layout_, rotation_, size_, band_y_,
+      resolve_span_op(color, raster_op),
+      [&](const auto& plot)
+      {
+        const auto PLOT = [&](int32_t x, int32_t y)
+        {
+          if (INSIDE ||
+              InClip(Point{static_cast<int16_t>(x), static_cast<int16_t>(y)}))
+          {
+            plot(x, y);
+          }
+        };
+        // Mirrors skip offsets that land on the same pixel, so XOR outlines stay
+        // closed.
+        const auto POINT = [&](int32_t a, int32_t b)
+        {
+          const bool MIRROR_X = a != 0 || LEFT != RIGHT;
+          const bool MIRROR_Y = b != 0 || TOP != BOTTOM;
+          PLOT(LEFT - a, TOP - b);
+          if (MIRROR_X)
+          {
+            PLOT(RIGHT + a, TOP - b);
+          }
+          if (MIRROR_Y)
+          {
+            PLOT(LEFT - a, BOTTOM + b);
+            if (MIRROR_X)
+            {
+              PLOT(RIGHT + a, BOTTOM + b);
+            }
+          }
+        };
+        if (radius_x == radius_y)
+        {
+          circle_quadrant(radius_x, POINT);
+        }
+        else
+        {
+          ellipse_quadrant(radius_x, radius_y, POINT);
+        }
+      });
+
+  // Straight edges between the arcs.
+  const auto EDGE = [&](Rect edge)
+  {
+    edge = intersect_rect(edge, clip_);
+    if (!rect_empty(edge))
+    {
+      FillRectUnchecked(edge, color, raster_op);
+    }
+  };
+  if (inner.w > 2U)
+  {
+    const uint16_t LENGTH = static_cast<uint16_t>(inner.w - 2U);
+    const int16_t X = static_cast<int16_t>(LEFT + 1);
+    EDGE(Rect{X, BOX.y, LENGTH, 1});
+    if (BOX.h > 1U)
+    {
+      EDGE(Rect{X, static_cast<int16_t>(BOTTOM + radius_y), LENGTH, 1});
+    }
+  }
+  if (inner.h > 2U)
+  {
+    const uint16_t LENGTH = static_cast<uint16_t>(inner.h - 2U);
+    const int16_t Y = static_cast<int16_t>(TOP + 1);
+    EDGE(Rect{BOX.x, Y, 1, LENGTH});
+    if (BOX.w > 1U)
+    {
+      EDGE(Rect{static_cast<int16_t>(RIGHT + radius_x), Y, 1, LENGTH});
+    }
+  }
+
+  MarkDirty(VISIBLE);
+}
+
+void Surface::FillRound(Rect inner, uint8_t radius_x, uint8_t radius_y, Color color,
+                        RasterOp raster_op) noexcept
+{
+  const Rect BOX = round_box(inner, radius_x, radius_y);
+  const Rect VISIBLE = intersect_rect(BOX, clip_);
+  if (bits_ == nullptr || rect_empty(VISIBLE))
+  {
+    return;
+  }
+
+  const int32_t TOP = inner.y;
+  const int32_t BOTTOM = inner.y + static_cast<int32_t>(inner.h) - 1;
+  const auto SPAN = [&](int32_t y, int32_t half_width)
+  {
+    const Rect ROW{
+        static_cast<int16_t>(inner.x - half_width),
+        static_cast<int16_t>(y),
+        static_cast<uint16_t>(inner.w + 2U * static_cast<uint32_t>(half_width)),
+        1,
+    };
+    const Rect CLIPPED = intersect_rect(ROW, clip_);
+    if (!rect_empty(CLIPPED))
+    {
+      FillRectUnchecked(CLIPPED, color, raster_op);
+    }
+  };
+  // Each row is filled once: arc rows above and below, then the straight middle.
+  const auto ROW = [&](int32_t dy, int32_t half_width)
+  {
+    SPAN(TOP - dy, half_width);
+    if (dy != 0 || TOP != BOTTOM)
+    {
+      SPAN(BOTTOM + dy, half_width);
+    }
+  };
+  if (radius_x == radius_y)
+  {
+    circle_rows(radius_x, ROW);
+  }
+  else
+  {
+    ellipse_rows(radius_x, radius_y, ROW);
+  }
+  if (inner.h > 2U)
+  {
+    const Rect MIDDLE = intersect_rect(
+        Rect{BOX.x, static_cast<int16_t>(TOP + 1), BOX.w,
+             static_cast<uint16_t>(inner.h - 2U)},
+        clip_);
+    if (!rect_empty(MIDDLE))
+    {
+      FillRectUnchecked(MIDDLE, color, raster_op);
+    }
+  }
+
+  MarkDirty(VISIBLE);
+}
+
 void Surface::PlotUnchecked(int16_t x, int16_t y, Color color,
                             RasterOp raster_op) noexcept
 {
@@ -454,59 +2814,217 @@ void Surface::PlotUnchecked(int16_t x, int16_t y, Color color,
     return;
   }
 
-  const std::size_t BYTE_INDEX =
-      static_cast<std::size_t>(y) * stride_bytes_ + static_cast<std::size_t>(x / 8);
-  const uint8_t MASK = static_cast<uint8_t>(0x80U >> (x & 0x7));
-  const bool SRC_IS_SET = (color == Color::WHITE);
-  uint8_t& dst = bits_[BYTE_INDEX];
+  const SpanOp OP = resolve_span_op(color, raster_op);
+  const Point DEVICE = rotate_point(x, y, rotation_, size_);
+  const int32_t COL = DEVICE.x;
+  const int32_t ROW = static_cast<int32_t>(DEVICE.y) - band_y_;
+  with_layout(layout_,
+              [&](auto layout)
+              {
+                using Layout = decltype(layout);
+                apply_mask(*Layout::Byte(bits_, stride_bytes_, COL, ROW),
+                           Layout::Mask(COL, ROW), OP);
+              });
+}
 
-  switch (raster_op)
+void Surface::FillRectUnchecked(Rect rect, Color color, RasterOp raster_op) noexcept
+{
+  const SpanOp OP = resolve_span_op(color, raster_op);
+  if (stride_bytes_ == 0 || OP == SpanOp::NONE)
   {
-    case RasterOp::COPY:
-      if (SRC_IS_SET)
-      {
-        dst |= MASK;
-      }
-      else
-      {
-        dst &= static_cast<uint8_t>(~MASK);
-      }
-      break;
-    case RasterOp::XOR:
-      if (SRC_IS_SET)
-      {
-        dst ^= MASK;
-      }
-      break;
-    case RasterOp::AND:
-      if (!SRC_IS_SET)
-      {
-        dst &= static_cast<uint8_t>(~MASK);
-      }
-      break;
-    case RasterOp::OR:
-      if (SRC_IS_SET)
-      {
-        dst |= MASK;
-      }
-      break;
+    return;
+  }
+
+  // A span along the rotated x axis becomes a column on R90/R270 panels; fill_rect
+  // walks whichever axis is native.
+  rect = rotate_rect(rect, rotation_, size_);
+  rect.y = static_cast<int16_t>(rect.y - static_cast<int32_t>(band_y_));
+  with_layout(layout_,
+              [&](auto layout)
+              { fill_rect<decltype(layout)>(bits_, stride_bytes_, rect, OP); });
+}
+
+void Surface::BlitRleGlyph(Point origin, Rect clipped, const Font& font,
+                           const FontGlyph& glyph, uint8_t scale_x, uint8_t scale_y,
+                           Color color, RasterOp raster_op) noexcept
+{
+  if (resolve_span_op(color, raster_op) == SpanOp::NONE)
+  {
+    return;
   }
+
+  // Set runs go straight to the span filler; nothing is decoded into a buffer.
+  const uint32_t WIDTH = glyph.width;
+  decode_rle_glyph(font, glyph,
+                   [&](uint32_t pos, uint32_t length)
+                   {
+                     uint32_t row = pos / WIDTH;
+                     uint32_t column = pos % WIDTH;
+                     while (length != 0U)
+                     {
+                       const uint32_t COUNT = std::min(length, WIDTH - column);
+                       const Rect SPAN{
+                           static_cast<int16_t>(origin.x +
+                                                static_cast<int32_t>(column) * scale_x),
+                           static_cast<int16_t>(origin.y +
+                                                static_cast<int32_t>(row) * scale_y),
+                           static_cast<uint16_t>(COUNT * scale_x),
+                           scale_y,
+                       };
+                       const Rect CLIPPED = intersect_rect(SPAN, clipped);
+                       if (!rect_empty(CLIPPED))
+                       {
+                         FillRectUnchecked(CLIPPED, color, raster_op);
+                       }
+                       length -= COUNT;
+                       column = 0;
+                       ++row;
+                     }
+                   });
 }
 
-void Surface::MarkDirty(Rect rect) noexcept
+void Surface::BlitUnchecked(Point origin, Rect clipped, const BlitSource& source,
+                            Color foreground, RasterOp raster_op,
+                            BitmapMode mode) noexcept
 {
-  Rect clipped = intersect_rect(rect, Bounds());
-  if (rect_empty(clipped))
+  BlitMerge merge{};
+  merge.mode = mode;
+  merge.raster_op = raster_op;
+  merge.foreground_set = (foreground == Color::WHITE);
+  merge.span_op = resolve_span_op(foreground, raster_op);
+  if (stride_bytes_ == 0 ||
+      (mode == BitmapMode::TRANSPARENT && merge.span_op == SpanOp::NONE))
+  {
+    return;
+  }
+
+  const uint8_t SCALE_X = source.scale_x;
+  const uint8_t SCALE_Y = source.scale_y;
+  const int32_t X_BEGIN = clipped.x;
+  const int32_t X_END = X_BEGIN + static_cast<int32_t>(clipped.w);
+  const int32_t Y_BEGIN = clipped.y;
+  const int32_t Y_END = Y_BEGIN + static_cast<int32_t>(clipped.h);
+
+  // Row x scale expansion for the byte-wise path; 32 bytes covers 256 pixels.
+  constexpr uint16_t EXPANDED_BYTES = 32U;
+  const uint32_t SRC_W =
+      (static_cast<uint32_t>(X_END - origin.x) + SCALE_X - 1U) / SCALE_X;
+  const bool ROW_PATH = rotation_ == Rotation::R0 &&
+                        layout_ != PixelLayout::VERTICAL_PAGE &&
+                        (SCALE_X == 1 || SRC_W * SCALE_X <= EXPANDED_BYTES * 8U);
+  if (ROW_PATH)
   {
+    std::array<uint8_t, EXPANDED_BYTES> expanded{};
+    std::array<uint8_t, EXPANDED_BYTES> expanded_mask{};
+    int32_t expanded_row = -1;
+    with_layout(layout_,
+                [&](auto layout)
+                {
+                  using Layout = decltype(layout);
+                  for (int32_t y = Y_BEGIN; y < Y_END; ++y)
+                  {
+                    const std::size_t SRC_OFFSET =
+                        static_cast<std::size_t>((y - origin.y) / SCALE_Y) *
+                        source.stride_bytes;
+                    const uint8_t* src_row = source.bits + SRC_OFFSET;
+                    const uint8_t* mask_row =
+                        (source.mask != nullptr) ? source.mask + SRC_OFFSET : nullptr;
+                    if (SCALE_X > 1)
+                    {
+                      const int32_t SRC_Y = (y - origin.y) / SCALE_Y;
+                      if (SRC_Y != expanded_row)
+                      {
+                        expand_row_bits(src_row, static_cast<uint16_t>(SRC_W), SCALE_X,
+                                        expanded.data());
+                        if (mask_row != nullptr)
+                        {
+                          expand_row_bits(mask_row, static_cast<uint16_t>(SRC_W), SCALE_X,
+                                          expanded_mask.data());
+                        }
+                        expanded_row = SRC_Y;
+                      }
+                      src_row = expanded.data();
+                      mask_row = (mask_row != nullptr) ? expanded_mask.data() : nullptr;
+                    }
+                    uint8_t* row = Layout::Byte(bits_, stride_bytes_, 0, y - band_y_);
+                    blit_row<Layout>(row, X_BEGIN, X_END, src_row, mask_row,
+                                     X_BEGIN - origin.x, merge);
+                  }
+                });
     return;
   }
 
-  if (rect_empty(dirty_))
+  if (rotation_ == Rotation::R0 && layout_ == PixelLayout::VERTICAL_PAGE && SCALE_X == 1)
   {
-    dirty_ = clipped;
+    // A page at a time: the source rows of its eight panel rows feed blit_page().
+    const int32_t PAGE_BEGIN = (Y_BEGIN - band_y_) / 8;
+    const int32_t PAGE_END = (Y_END - 1 - band_y_) / 8;
+    for (int32_t page = PAGE_BEGIN; page <= PAGE_END; ++page)
+    {
+      std::array<const uint8_t*, 8> src_rows{};
+      std::array<const uint8_t*, 8> mask_rows{};
+      const int32_t PAGE_Y = band_y_ + page * 8;
+      for (int32_t k = 0; k < 8; ++k)
+      {
+        const int32_t Y = PAGE_Y + k;
+        if (Y < Y_BEGIN || Y >= Y_END)
+        {
+          continue;
+        }
+        const std::size_t SRC_OFFSET =
+            static_cast<std::size_t>((Y - origin.y) / SCALE_Y) * source.stride_bytes;
+        src_rows[k] = source.bits + SRC_OFFSET;
+        mask_rows[k] = (source.mask != nullptr) ? source.mask + SRC_OFFSET : nullptr;
+      }
+      blit_page(bits_ + static_cast<std::size_t>(page) * stride_bytes_, X_BEGIN, X_END,
+                src_rows, mask_rows, X_BEGIN - origin.x, merge);
+    }
     return;
   }
-  dirty_ = union_rect(dirty_, clipped);
+
+  // Rotated targets, and x-scaled vertical-page ones: per source bit, still without
+  // clip or dirty work.
+  with_layout(layout_,
+              [&](auto layout)
+              {
+                using Layout = decltype(layout);
+                for (int32_t y = Y_BEGIN; y < Y_END; ++y)
+                {
+                  const std::size_t SRC_OFFSET =
+                      static_cast<std::size_t>((y - origin.y) / SCALE_Y) *
+                      source.stride_bytes;
+                  const uint8_t* src_row = source.bits + SRC_OFFSET;
+                  for (int32_t x = X_BEGIN; x < X_END; ++x)
+                  {
+                    const int32_t SRC_X = (x - origin.x) / SCALE_X;
+                    const uint8_t SRC_BIT = static_cast<uint8_t>(0x80U >> (SRC_X & 0x7));
+                    const std::size_t SRC_BYTE = static_cast<std::size_t>(SRC_X / 8);
+                    if (source.mask != nullptr &&
+                        (source.mask[SRC_OFFSET + SRC_BYTE] & SRC_BIT) == 0U)
+                    {
+                      continue;
+                    }
+                    const Point DEVICE = rotate_point(x, y, rotation_, size_);
+                    const int32_t ROW = static_cast<int32_t>(DEVICE.y) - band_y_;
+                    const uint8_t MASK = Layout::Mask(DEVICE.x, ROW);
+                    const bool SET = (src_row[SRC_BYTE] & SRC_BIT) != 0U;
+                    merge(*Layout::Byte(bits_, stride_bytes_, DEVICE.x, ROW),
+                          SET ? MASK : static_cast<uint8_t>(0U), MASK);
+                  }
+                }
+              });
+}
+
+void Surface::MarkDirty(Rect rect) noexcept { MarkDeviceDirty(ToDeviceRect(rect)); }
+
+void Surface::MarkDeviceDirty(Rect rect) noexcept
+{
+  const Rect CLIPPED = intersect_rect(rect, DeviceBounds());
+  dirty_.Add(CLIPPED);
+  if (page_dirty_enabled_)
+  {
+    page_dirty_.Add(CLIPPED);
+  }
 }
 
 }  // namespace MonoGL
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 
 namespace LibXR
@@ -22,6 +23,22 @@ enum class RasterOp : uint8_t
   OR = 3
 };
 
+// Clockwise rotation of the drawing coordinates relative to the panel.
+enum class Rotation : uint8_t
+{
+  R0,
+  R90,
+  R180,
+  R270
+};
+
+enum class PixelLayout : uint8_t
+{
+  ROW_MAJOR_MSB = 0,  // Rows of bytes, leftmost pixel in bit 7.
+  ROW_MAJOR_LSB = 1,  // Rows of bytes, leftmost pixel in bit 0.
+  VERTICAL_PAGE = 2   // 8-row pages of column bytes, top pixel in bit 0 (SSD1306 GDDRAM).
+};
+
 struct Point
 {
   int16_t x{0};
@@ -88,7 +105,173 @@ inline Rect union_rect(Rect a, Rect b) noexcept
   };
 }
 
-struct Font;  // Forward declaration.
+// rect moved by (dx, dy); whatever would leave the int16_t coordinate range is dropped.
+inline Rect offset_rect(Rect rect, int32_t dx, int32_t dy) noexcept
+{
+  const int32_t LEFT = std::max<int32_t>(rect.x + dx, INT16_MIN);
+  const int32_t TOP = std::max<int32_t>(rect.y + dy, INT16_MIN);
+  const int32_t RIGHT =
+      std::min<int32_t>(rect.x + dx + static_cast<int32_t>(rect.w), INT16_MAX);
+  const int32_t BOTTOM =
+      std::min<int32_t>(rect.y + dy + static_cast<int32_t>(rect.h), INT16_MAX);
+  if (RIGHT <= LEFT || BOTTOM <= TOP)
+  {
+    return Rect{};
+  }
+  return Rect{
+      static_cast<int16_t>(LEFT),
+      static_cast<int16_t>(TOP),
+      static_cast<uint16_t>(RIGHT - LEFT),
+      static_cast<uint16_t>(BOTTOM - TOP),
+  };
+}
+
+// A line is one pixel row in row-major layouts and one 8-row page in VERTICAL_PAGE.
+inline uint16_t layout_default_stride(uint16_t width, PixelLayout layout) noexcept
+{
+  if (layout == PixelLayout::VERTICAL_PAGE)
+  {
+    return width;
+  }
+  return static_cast<uint16_t>((width + 7U) / 8U);
+}
+
+inline uint16_t layout_line_count(uint16_t rows, PixelLayout layout) noexcept
+{
+  if (layout == PixelLayout::VERTICAL_PAGE)
+  {
+    return static_cast<uint16_t>((rows + 7U) / 8U);
+  }
+  return rows;
+}
+
+// Bytes [byte_begin, byte_end) of lines [line_begin, line_end) that hold a rect.
+struct ByteWindow
+{
+  uint16_t byte_begin{0};
+  uint16_t byte_end{0};
+  uint16_t line_begin{0};
+  uint16_t line_end{0};
+};
+
+// rect must be non-empty and lie in non-negative coordinates.
+inline ByteWindow layout_byte_window(Rect rect, PixelLayout layout) noexcept
+{
+  const uint32_t X_END = static_cast<uint32_t>(rect.x) + rect.w;
+  const uint32_t Y_END = static_cast<uint32_t>(rect.y) + rect.h;
+  if (layout == PixelLayout::VERTICAL_PAGE)
+  {
+    return ByteWindow{
+        static_cast<uint16_t>(rect.x),
+        static_cast<uint16_t>(X_END),
+        static_cast<uint16_t>(rect.y / 8),
+        static_cast<uint16_t>((Y_END + 7U) / 8U),
+    };
+  }
+  return ByteWindow{
+      static_cast<uint16_t>(rect.x / 8),
+      static_cast<uint16_t>((X_END + 7U) / 8U),
+      static_cast<uint16_t>(rect.y),
+      static_cast<uint16_t>(Y_END),
+  };
+}
+
+// Small fixed-capacity set of dirty rects. Overlapping or touching rects are merged on
+// insert; when the set is full the pair whose union wastes the least area is merged.
+class DirtyRegion
+{
+ public:
+  static constexpr uint8_t MAX_RECTS = 4;
+
+  void Clear() noexcept;
+  void Add(Rect rect) noexcept;
+  // Merges cheapest pairs until at most max_rects remain (0 is treated as 1).
+  void ReduceTo(uint8_t max_rects) noexcept;
+
+  bool Empty() const noexcept { return count_ == 0; }
+  uint8_t Count() const noexcept { return count_; }
+  const Rect* Rects() const noexcept { return rects_.data(); }
+  Rect Bounds() const noexcept;
+
+ private:
+  void Remove(uint8_t index) noexcept;
+
+  // One spare slot so Add can append before reducing back to MAX_RECTS.
+  std::array<Rect, MAX_RECTS + 1> rects_{};
+  uint8_t count_{0};
+};
+
+// Dirty columns [x_begin, x_end) of one page; empty when x_end <= x_begin.
+struct PageSpan
+{
+  uint16_t x_begin{0};
+  uint16_t x_end{0};
+};
+
+// Per-page dirty column ranges in the 8-row page units SSD1306/SH1106-style controllers
+// address. Rows at or beyond MAX_PAGES * PAGE_ROWS are not tracked.
+class PageDirtyMap
+{
+ public:
+  static constexpr uint8_t PAGE_ROWS = 8;
+  static constexpr uint8_t MAX_PAGES = 16;
+
+  void Clear() noexcept;
+  void Add(Rect rect) noexcept;
+
+  const PageSpan* Spans() const noexcept { return spans_.data(); }
+
+ private:
+  std::array<PageSpan, MAX_PAGES> spans_{};
+};
+
+// Adds the pixels inside window (device coordinates) that differ between two frames of
+// the same geometry to region, one rect per 8-row page, and to pages when given.
+void diff_frames(const uint8_t* current, const uint8_t* previous, Size size,
+                 uint16_t stride_bytes, PixelLayout layout, Rect window,
+                 DirtyRegion& region, PageDirtyMap* pages) noexcept;
+
+enum class BitmapMode : uint8_t
+{
+  TRANSPARENT = 0,  // Zero source bits leave the destination untouched.
+  OPAQUE = 1        // Zero source bits draw the opposite of foreground.
+};
+
+struct BitmapStyle
+{
+  Color foreground{Color::WHITE};
+  RasterOp raster_op{RasterOp::COPY};
+  BitmapMode mode{BitmapMode::TRANSPARENT};
+  // Optional mask plane packed like the image; only pixels with a set mask bit are drawn.
+  const uint8_t* mask{nullptr};
+  uint16_t stride_bytes{0};  // Image and mask stride; 0 means ceil(width / 8).
+};
+
+enum class DitherMode : uint8_t
+{
+  THRESHOLD = 0,       // Samples above 127 are white.
+  ORDERED = 1,         // 8x8 Bayer matrix anchored at the image origin.
+  FLOYD_STEINBERG = 2  // Error diffusion; needs GrayStyle::errors.
+};
+
+struct GrayStyle
+{
+  DitherMode dither{DitherMode::ORDERED};
+  uint16_t stride_bytes{0};  // Sample stride of an in-memory image; 0 means width.
+  // Floyd-Steinberg error row of at least width + 1 entries; without it the image is
+  // drawn ORDERED. Its contents are reset per image.
+  int16_t* errors{nullptr};
+  uint16_t error_count{0};
+};
+
+// Returns row y (0 at the top) of a grayscale image: width 8-bit samples, 0 black to
+// 255 white, valid until the next call. Rows are asked for in order; nullptr leaves a
+// row untouched and drops the Floyd-Steinberg error diffused into it.
+using GrayRowFn = const uint8_t* (*)(void* context, uint16_t y);
+
+struct Font;         // Forward declaration.
+struct FontGlyph;    // Forward declaration.
+class GlyphCache;    // Forward declaration.
 
 struct TextStyle
 {
@@ -98,18 +281,67 @@ struct TextStyle
   uint8_t scale_x{1};
   uint8_t scale_y{1};
   int8_t letter_spacing{0};
+  GlyphCache* glyph_cache{nullptr};  // Optional cache of x-expanded glyphs.
+};
+
+enum class TextAlign : uint8_t
+{
+  LEFT,
+  CENTER,
+  RIGHT
+};
+
+// One line of a layout_text() paragraph. text points into the laid out string, which
+// must outlive the lines.
+struct TextLine
+{
+  const char* text{nullptr};
+  uint16_t length{0};  // Bytes, without the break.
+  int16_t width{0};    // Pen advance, as measure_text() reports it.
 };
 
+// Baseline origin DrawTextTopLeft() uses for top_left.
+Point text_baseline(Point top_left, const TextStyle& style) noexcept;
+// Unclipped box of the glyphs DrawText(baseline_left, text, style) draws.
+Rect text_bounds(Point baseline_left, const char* text, const TextStyle& style) noexcept;
+// Baseline step between the lines of multi-line text.
+uint16_t text_line_pitch(const TextStyle& style) noexcept;
+// Pen advance of the widest line (without the trailing letter spacing) and the height
+// of all lines. Touches no pixels.
+Size measure_text(const char* text, const TextStyle& style) noexcept;
+// Breaks text at '\n' and wraps lines wider than max_width at spaces, or between glyphs
+// inside a word that does not fit. Returns the line count; lines beyond capacity are
+// counted but not stored. Lay a paragraph out once and draw it with DrawTextLines().
+uint16_t layout_text(const char* text, int16_t max_width, const TextStyle& style,
+                     TextLine* lines, uint16_t capacity) noexcept;
+// Unclipped box of the glyphs DrawTextLines(box, lines, count, style, align) draws.
+Rect text_lines_bounds(Rect box, const TextLine* lines, uint16_t count,
+                       const TextStyle& style, TextAlign align) noexcept;
+
 class Surface
 {
  public:
   Surface() = default;
 
-  // stride_bytes = 0 means auto: ceil(width / 8).
-  void Bind(uint8_t* bits, Size size, uint16_t stride_bytes = 0) noexcept;
+  // stride_bytes = 0 means auto: layout_default_stride(width, layout).
+  void Bind(uint8_t* bits, Size size, uint16_t stride_bytes = 0,
+            PixelLayout layout = PixelLayout::ROW_MAJOR_MSB) noexcept;
+  // Binds a band of a taller frame: bits holds row_count rows starting at frame row
+  // first_row. Drawing keeps frame coordinates and is clipped to the band.
+  // VERTICAL_PAGE bands must start on a multiple of 8 rows.
+  void BindBand(uint8_t* bits, Size size, uint16_t first_row, uint16_t row_count,
+                uint16_t stride_bytes = 0,
+                PixelLayout layout = PixelLayout::ROW_MAJOR_MSB) noexcept;
+
+  // The binding does not reset rotation. Drawing, clip and GetSize() use rotated
+  // coordinates; dirty rects and the band stay in panel (framebuffer) coordinates.
+  void SetRotation(Rotation rotation) noexcept;
+  Rotation GetRotation() const noexcept;
 
   Size GetSize() const noexcept;
+  Rect GetBand() const noexcept;
   uint16_t GetStrideBytes() const noexcept;
+  PixelLayout GetLayout() const noexcept;
   void Clear(Color color = Color::BLACK) noexcept;
 
   void SetClip(Rect rect) noexcept;
@@ -130,32 +362,137 @@ class Surface
                 RasterOp raster_op = RasterOp::COPY) noexcept;
   void DrawCircle(Point center, uint8_t radius, Color color = Color::WHITE,
                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillCircle(Point center, uint8_t radius, Color color = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                   Color color = Color::WHITE,
+                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillEllipse(Point center, uint8_t radius_x, uint8_t radius_y,
+                   Color color = Color::WHITE,
+                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  // radius is limited to half the shorter side.
+  void DrawRoundRect(Rect rect, uint8_t radius, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillRoundRect(Rect rect, uint8_t radius, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
+
+  // Copies the pixels of src to dst_top_left; the areas may overlap. Only the
+  // destination is clipped. Source pixels outside the bound rows are not copied, so in
+  // a band only the rows it holds move.
+  void CopyRect(Rect src, Point dst_top_left) noexcept;
+  // Moves the content of rect (clipped) by dx, dy and fills what is uncovered with
+  // fill. Nothing outside rect is read or written.
+  void ScrollRect(Rect rect, int16_t dx, int16_t dy, Color fill = Color::BLACK) noexcept;
+
+  // Batch calls clip and mark dirty once per call rather than once per element.
+  // Consecutive segments share their vertex, which is plotted once.
+  void DrawPolyline(const Point* points, uint16_t count, Color color = Color::WHITE,
+                    RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawPixels(const Point* points, uint16_t count, Color color = Color::WHITE,
+                  RasterOp raster_op = RasterOp::COPY) noexcept;
+  void FillRects(const Rect* rects, uint16_t count, Color color = Color::WHITE,
+                 RasterOp raster_op = RasterOp::COPY) noexcept;
+  // Bar i is bar_width pixels wide at area.x + i * bar_width and rises heights[i]
+  // pixels (at most area.h) from the bottom of area. Bars past area are dropped.
+  void DrawHistogram(Rect area, const uint8_t* heights, uint16_t count,
+                     uint8_t bar_width = 1, Color color = Color::WHITE,
+                     RasterOp raster_op = RasterOp::COPY) noexcept;
 
+  // bits (and style.mask) are 1bpp, row-major, MSB-first.
   void DrawBitmap(Point point, const uint8_t* bits, Size size,
                   Color foreground = Color::WHITE,
                   RasterOp raster_op = RasterOp::COPY) noexcept;
+  void DrawBitmap(Point point, const uint8_t* bits, Size size,
+                  const BitmapStyle& style) noexcept;
+  // Dithers 8-bit grayscale to white and black pixels as rows are drawn, so an image
+  // can be decoded a row at a time. gray holds size.h rows of size.w samples. Rows are
+  // written a byte at a time on unrotated surfaces, as by DrawBitmap(); rotated ones go
+  // pixel by pixel.
+  void DrawGray8(Point point, const uint8_t* gray, Size size,
+                 const GrayStyle& style = GrayStyle{}) noexcept;
+  void DrawGray8(Point point, Size size, GrayRowFn row, void* context,
+                 const GrayStyle& style = GrayStyle{}) noexcept;
+  // text is UTF-8 (see utf8_next()); '\n' starts a new line.
   void DrawText(Point baseline_left, const char* text, const TextStyle& style) noexcept;
   void DrawText(Point baseline_left, const char* text, const TextStyle& style,
                 RasterOp raster_op) noexcept;
   void DrawTextTopLeft(Point top_left, const char* text, const TextStyle& style) noexcept;
   void DrawTextTopLeft(Point top_left, const char* text, const TextStyle& style,
                        RasterOp raster_op) noexcept;
+  // Draws laid out lines top down from the top of box, aligned within box.w. Lines
+  // starting at or below the bottom of box are skipped.
+  void DrawTextLines(Rect box, const TextLine* lines, uint16_t count,
+                     const TextStyle& style, TextAlign align = TextAlign::LEFT) noexcept;
 
+  // Bounding box of the dirty region.
   Rect GetDirtyRect() const noexcept;
+  const DirtyRegion& GetDirtyRegion() const noexcept;
+  // Page tracking is off by default; it costs one span update per touched page.
+  void EnablePageDirty(bool enable) noexcept;
+  bool IsPageDirtyEnabled() const noexcept;
+  const PageDirtyMap& GetPageDirty() const noexcept;
   void ClearDirtyRect() noexcept;
+  // Panel coordinates, like GetDirtyRect().
   void AddDirtyRect(Rect rect) noexcept;
+  // Maps a rect in rotated coordinates to panel coordinates, clipped to the bound rows.
+  Rect ToDeviceRect(Rect rect) const noexcept;
 
  private:
+  // Rows backed by bits_, in rotated coordinates.
   Rect Bounds() const noexcept;
+  // Rows backed by bits_, in panel coordinates.
+  Rect DeviceBounds() const noexcept;
   bool InClip(Point point) const noexcept;
   void PlotUnchecked(int16_t x, int16_t y, Color color, RasterOp raster_op) noexcept;
+  // Clips and draws p0-p1, optionally without p0; returns the box of what it drew.
+  // Dirty is left to the caller.
+  Rect PlotLine(Point p0, Point p1, bool skip_first, Color color,
+                RasterOp raster_op) noexcept;
+  // Circle, ellipse or rounded rect: quarter arcs of radius_x by radius_y around the
+  // corners of inner. Equal radii follow the midpoint circle.
+  void DrawRound(Rect inner, uint8_t radius_x, uint8_t radius_y, Color color,
+                 RasterOp raster_op) noexcept;
+  void FillRound(Rect inner, uint8_t radius_x, uint8_t radius_y, Color color,
+                 RasterOp raster_op) noexcept;
+  // rect must already be clipped to clip_.
+  void FillRectUnchecked(Rect rect, Color color, RasterOp raster_op) noexcept;
+  // 1bpp MSB-first image, each bit scaled to scale_x * scale_y pixels.
+  struct BlitSource
+  {
+    const uint8_t* bits{nullptr};
+    const uint8_t* mask{nullptr};
+    uint16_t stride_bytes{0};
+    uint8_t scale_x{1};
+    uint8_t scale_y{1};
+  };
+
+  // Draws source with its top-left at origin. clipped is the image rect intersected
+  // with clip_; nothing outside it is read or written. Unrotated surfaces are written a
+  // byte at a time: row-major rows, or vertical pages when scale_x is 1. Rotated
+  // surfaces, and x-scaled sources on vertical pages, go pixel by pixel.
+  void BlitUnchecked(Point origin, Rect clipped, const BlitSource& source,
+                     Color foreground, RasterOp raster_op, BitmapMode mode) noexcept;
+  // DrawText() of the text up to end or NUL.
+  void DrawTextSpan(Point baseline_left, const char* text, const char* end,
+                    const TextStyle& style) noexcept;
+  // Draws a FontFormat::RLE glyph with its box at origin, limited to clipped.
+  void BlitRleGlyph(Point origin, Rect clipped, const Font& font, const FontGlyph& glyph,
+                    uint8_t scale_x, uint8_t scale_y, Color color,
+                    RasterOp raster_op) noexcept;
   void MarkDirty(Rect rect) noexcept;
+  void MarkDeviceDirty(Rect rect) noexcept;
 
   uint8_t* bits_{nullptr};
   Size size_{};
   uint16_t stride_bytes_{0};
+  uint16_t band_y_{0};
+  uint16_t band_rows_{0};
+  PixelLayout layout_{PixelLayout::ROW_MAJOR_MSB};
+  Rotation rotation_{Rotation::R0};
   Rect clip_{};
-  Rect dirty_{};
+  DirtyRegion dirty_{};
+  PageDirtyMap page_dirty_{};
+  bool page_dirty_enabled_{false};
 };
 
 }  // namespace MonoGL
@@ -0,0 +1,101 @@
+#include "transfer_chunks.hpp"
+
+#include <algorithm>
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+namespace
+{
+
+// Pixels held by bytes [byte_begin, byte_end) of lines [line_begin, line_end).
+Rect byte_window_rect(ByteWindow window, PixelLayout layout) noexcept
+{
+  const uint16_t BYTES = static_cast<uint16_t>(window.byte_end - window.byte_begin);
+  const uint16_t LINES = static_cast<uint16_t>(window.line_end - window.line_begin);
+  if (layout == PixelLayout::VERTICAL_PAGE)
+  {
+    return Rect{static_cast<int16_t>(window.byte_begin),
+                static_cast<int16_t>(window.line_begin * 8U), BYTES,
+                static_cast<uint16_t>(LINES * 8U)};
+  }
+  return Rect{static_cast<int16_t>(window.byte_begin * 8U),
+              static_cast<int16_t>(window.line_begin), static_cast<uint16_t>(BYTES * 8U),
+              LINES};
+}
+
+}  // namespace
+
+void ChunkCursor::Start(const Rect* windows, uint8_t count, PixelLayout layout,
+                        uint16_t max_bytes) noexcept
+{
+  count_ = std::min<uint8_t>(count, DirtyRegion::MAX_RECTS);
+  std::copy(windows, windows + count_, windows_.begin());
+  layout_ = layout;
+  max_bytes_ = std::max<uint16_t>(max_bytes, 1U);
+  window_ = 0;
+  EnterWindow();
+}
+
+void ChunkCursor::Clear() noexcept
+{
+  count_ = 0;
+  window_ = 0;
+}
+
+void ChunkCursor::EnterWindow() noexcept
+{
+  if (window_ >= count_)
+  {
+    return;
+  }
+  bytes_ = layout_byte_window(windows_[window_], layout_);
+  line_ = bytes_.line_begin;
+  byte_ = bytes_.byte_begin;
+}
+
+bool ChunkCursor::Next(Rect& chunk) noexcept
+{
+  while (window_ < count_ && line_ >= bytes_.line_end)
+  {
+    ++window_;
+    EnterWindow();
+  }
+  if (window_ >= count_)
+  {
+    return false;
+  }
+
+  ByteWindow piece = bytes_;
+  const uint16_t LINE_BYTES = static_cast<uint16_t>(bytes_.byte_end - bytes_.byte_begin);
+  if (LINE_BYTES <= max_bytes_)
+  {
+    const uint16_t LINES =
+        std::min<uint16_t>(static_cast<uint16_t>(max_bytes_ / LINE_BYTES),
+                           static_cast<uint16_t>(bytes_.line_end - line_));
+    piece.line_begin = line_;
+    piece.line_end = static_cast<uint16_t>(line_ + LINES);
+    line_ = piece.line_end;
+  }
+  else
+  {
+    piece.line_begin = line_;
+    piece.line_end = static_cast<uint16_t>(line_ + 1U);
+    piece.byte_begin = byte_;
+    piece.byte_end = static_cast<uint16_t>(
+        std::min<uint32_t>(static_cast<uint32_t>(byte_) + max_bytes_, bytes_.byte_end));
+    byte_ = piece.byte_end;
+    if (byte_ >= bytes_.byte_end)
+    {
+      byte_ = bytes_.byte_begin;
+      ++line_;
+    }
+  }
+  chunk = intersect_rect(windows_[window_], byte_window_rect(piece, layout_));
+  return true;
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
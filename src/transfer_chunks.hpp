@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "surface.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+// Walks the windows of a present as chunks of at most max_bytes framebuffer bytes, in
+// window order: whole lines (pixel rows, or 8-row pages for VERTICAL_PAGE) while they
+// fit, else byte runs of a single line. The cursor keeps no more than the windows, so a
+// transfer can start with the first chunk without packing the rest up front.
+class ChunkCursor
+{
+ public:
+  // windows must be non-empty rects in non-negative device coordinates; at most
+  // DirtyRegion::MAX_RECTS are kept. max_bytes of 0 is treated as 1.
+  void Start(const Rect* windows, uint8_t count, PixelLayout layout,
+             uint16_t max_bytes) noexcept;
+  // Writes the next chunk, clipped to its window; false once every window is covered.
+  bool Next(Rect& chunk) noexcept;
+  void Clear() noexcept;
+
+ private:
+  void EnterWindow() noexcept;
+
+  std::array<Rect, DirtyRegion::MAX_RECTS> windows_{};
+  uint8_t count_{0};
+  uint8_t window_{0};
+  PixelLayout layout_{PixelLayout::ROW_MAJOR_MSB};
+  uint16_t max_bytes_{1};
+  ByteWindow bytes_{};  // Byte window of the current window.
+  uint16_t line_{0};    // Next line of the current window.
+  uint16_t byte_{0};    // Next byte of line_ when its lines do not fit a chunk.
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,493 @@
+#include "widget.hpp"
+
+#include <algorithm>
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+namespace
+{
+
+constexpr uint8_t MAX_LABEL_LINES = 8;
+constexpr std::size_t VALUE_CHARS = 32;
+
+bool rect_contains(Rect outer, Rect inner) noexcept
+{
+  const int32_t OUTER_RIGHT = outer.x + static_cast<int32_t>(outer.w);
+  const int32_t OUTER_BOTTOM = outer.y + static_cast<int32_t>(outer.h);
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + static_cast<int32_t>(inner.w) <= OUTER_RIGHT &&
+         inner.y + static_cast<int32_t>(inner.h) <= OUTER_BOTTOM;
+}
+
+bool same_rect(Rect a, Rect b) noexcept
+{
+  return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+Color inverse(Color color) noexcept
+{
+  return (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+}
+
+// Writes value / 10^decimals followed by unit, truncated to size - 1 chars.
+void format_value(int32_t value, uint8_t decimals, const char* unit, char* out,
+                  std::size_t size) noexcept
+{
+  char digits[12];
+  std::size_t digit_count = 0;
+  uint32_t magnitude = (value < 0) ? 0U - static_cast<uint32_t>(value)
+                                   : static_cast<uint32_t>(value);
+  do
+  {
+    digits[digit_count++] = static_cast<char>('0' + magnitude % 10U);
+    magnitude /= 10U;
+  } while (magnitude != 0U);
+
+  const std::size_t PLACES = std::min<std::size_t>(decimals, 10U);
+  std::size_t length = 0;
+  auto put = [&](char ch)
+  {
+    if (length + 1U < size)
+    {
+      out[length++] = ch;
+    }
+  };
+  if (value < 0)
+  {
+    put('-');
+  }
+  // Digits beyond the stored ones are leading zeros.
+  const std::size_t WIDTH = std::max(digit_count, PLACES + 1U);
+  for (std::size_t i = WIDTH; i-- > 0;)
+  {
+    if (i + 1U == PLACES)
+    {
+      put('.');
+    }
+    put((i < digit_count) ? digits[i] : '0');
+  }
+  for (const char* p = unit; p != nullptr && *p != '\0'; ++p)
+  {
+    put(*p);
+  }
+  out[length] = '\0';
+}
+
+// Lays text out unwrapped and draws it aligned in box, centred vertically.
+void draw_text_box(Surface& surface, Rect box, const char* text, const TextStyle& style,
+                   TextAlign align) noexcept
+{
+  TextLine lines[MAX_LABEL_LINES];
+  const uint16_t COUNT = std::min<uint16_t>(
+      layout_text(text, INT16_MAX, style, lines, MAX_LABEL_LINES), MAX_LABEL_LINES);
+  const int32_t HEIGHT = static_cast<int32_t>(COUNT) * text_line_pitch(style) - 1;
+  const int32_t TOP = box.y + (static_cast<int32_t>(box.h) - HEIGHT) / 2;
+  const Rect LINES{box.x, static_cast<int16_t>(TOP), box.w, UINT16_MAX};
+  surface.DrawTextLines(LINES, lines, COUNT, style, align);
+}
+
+}  // namespace
+
+void SceneBase::BindStorage(Widget* nodes, uint16_t capacity) noexcept
+{
+  nodes_ = nodes;
+  capacity_ = capacity;
+  count_ = 0;
+}
+
+WidgetId SceneBase::AddLabel(Rect bounds, const char* text, const TextStyle& style,
+                             TextAlign align) noexcept
+{
+  Widget node{};
+  node.kind = WidgetKind::LABEL;
+  node.bounds = bounds;
+  node.style = style;
+  node.align = align;
+  node.data = text;
+  return Add(node);
+}
+
+WidgetId SceneBase::AddValue(Rect bounds, int32_t value, uint8_t decimals,
+                             const char* unit, const TextStyle& style,
+                             TextAlign align) noexcept
+{
+  Widget node{};
+  node.kind = WidgetKind::VALUE;
+  node.bounds = bounds;
+  node.style = style;
+  node.align = align;
+  node.decimals = decimals;
+  node.data = unit;
+  node.value = value;
+  return Add(node);
+}
+
+WidgetId SceneBase::AddIcon(Rect bounds, const uint8_t* bits, Size size,
+                            Color color) noexcept
+{
+  Widget node{};
+  node.kind = WidgetKind::ICON;
+  node.bounds = bounds;
+  node.style.color = color;
+  node.data = bits;
+  node.size = size;
+  return Add(node);
+}
+
+WidgetId SceneBase::AddBar(Rect bounds, int32_t value, int32_t min, int32_t max,
+                           Color color) noexcept
+{
+  Widget node{};
+  node.kind = WidgetKind::BAR;
+  node.bounds = bounds;
+  node.style.color = color;
+  node.value = value;
+  node.min = min;
+  node.max = max;
+  return Add(node);
+}
+
+WidgetId SceneBase::AddList(Rect bounds, const char* const* items, uint16_t count,
+                            const TextStyle& style) noexcept
+{
+  Widget node{};
+  node.kind = WidgetKind::LIST;
+  node.bounds = bounds;
+  node.style = style;
+  node.data = items;
+  node.value = -1;
+  node.max = count;
+  return Add(node);
+}
+
+WidgetId SceneBase::Add(const Widget& node) noexcept
+{
+  if (nodes_ == nullptr || count_ >= capacity_)
+  {
+    return INVALID_WIDGET;
+  }
+  nodes_[count_] = node;
+  damage_.Add(node.bounds);
+  return count_++;
+}
+
+Widget* SceneBase::Find(WidgetId id) noexcept
+{
+  return (id < count_) ? &nodes_[id] : nullptr;
+}
+
+const Widget* SceneBase::Get(WidgetId id) const noexcept
+{
+  return (id < count_) ? &nodes_[id] : nullptr;
+}
+
+void SceneBase::SetText(WidgetId id, const char* text) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || node->kind != WidgetKind::LABEL || node->data == text)
+  {
+    return;
+  }
+  node->data = text;
+  damage_.Add(node->bounds);
+}
+
+void SceneBase::SetValue(WidgetId id, int32_t value) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr ||
+      (node->kind != WidgetKind::VALUE && node->kind != WidgetKind::BAR) ||
+      node->value == value)
+  {
+    return;
+  }
+  node->value = value;
+  damage_.Add(node->bounds);
+}
+
+void SceneBase::SetBitmap(WidgetId id, const uint8_t* bits) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || node->kind != WidgetKind::ICON || node->data == bits)
+  {
+    return;
+  }
+  node->data = bits;
+  damage_.Add(node->bounds);
+}
+
+void SceneBase::SetItems(WidgetId id, const char* const* items, uint16_t count) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || node->kind != WidgetKind::LIST)
+  {
+    return;
+  }
+  node->data = items;
+  node->max = count;
+  node->value = std::min<int32_t>(node->value, static_cast<int32_t>(count) - 1);
+  node->min = std::max<int32_t>(0, std::min<int32_t>(node->min, count - 1));
+  damage_.Add(node->bounds);
+}
+
+Rect SceneBase::ListRow(const Widget& node, int32_t index) const noexcept
+{
+  const int32_t PITCH = text_line_pitch(node.style);
+  const int32_t TOP = node.bounds.y + (index - node.min) * PITCH;
+  return intersect_rect(
+      Rect{node.bounds.x, static_cast<int16_t>(TOP), node.bounds.w,
+           static_cast<uint16_t>(PITCH)},
+      node.bounds);
+}
+
+void SceneBase::SetSelected(WidgetId id, int32_t index) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || node->kind != WidgetKind::LIST)
+  {
+    return;
+  }
+  index = (index < 0 || index >= node->max) ? -1 : index;
+  if (index == node->value)
+  {
+    return;
+  }
+
+  // Scroll just enough to show the whole selected row.
+  const int32_t PITCH = std::max<int32_t>(text_line_pitch(node->style), 1);
+  const int32_t ROWS = std::max<int32_t>(node->bounds.h / PITCH, 1);
+  int32_t top = node->min;
+  if (index >= 0 && index < top)
+  {
+    top = index;
+  }
+  else if (index >= top + ROWS)
+  {
+    top = index - ROWS + 1;
+  }
+
+  if (top != node->min)
+  {
+    node->min = top;
+    damage_.Add(node->bounds);
+  }
+  else
+  {
+    // Only the rows that change highlight.
+    if (node->value >= 0)
+    {
+      damage_.Add(ListRow(*node, node->value));
+    }
+    if (index >= 0)
+    {
+      damage_.Add(ListRow(*node, index));
+    }
+  }
+  node->value = index;
+}
+
+void SceneBase::SetBounds(WidgetId id, Rect bounds) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || same_rect(node->bounds, bounds))
+  {
+    return;
+  }
+  damage_.Add(node->bounds);
+  node->bounds = bounds;
+  damage_.Add(bounds);
+}
+
+void SceneBase::SetVisible(WidgetId id, bool visible) noexcept
+{
+  Widget* node = Find(id);
+  if (node == nullptr || node->visible == visible)
+  {
+    return;
+  }
+  node->visible = visible;
+  damage_.Add(node->bounds);
+}
+
+void SceneBase::SetBackground(Color color) noexcept
+{
+  if (color != background_)
+  {
+    background_ = color;
+    full_ = true;
+  }
+}
+
+void SceneBase::Invalidate(WidgetId id) noexcept
+{
+  const Widget* node = Get(id);
+  if (node != nullptr)
+  {
+    damage_.Add(node->bounds);
+  }
+}
+
+Rect SceneBase::Render(Surface& surface) noexcept
+{
+  Rect rendered{};
+  if (full_)
+  {
+    rendered = surface.GetClip();
+    Repaint(surface, rendered);
+  }
+  else
+  {
+    for (uint8_t i = 0; i < damage_.Count(); ++i)
+    {
+      const Rect AREA = intersect_rect(damage_.Rects()[i], surface.GetClip());
+      Repaint(surface, AREA);
+      rendered = union_rect(rendered, AREA);
+    }
+  }
+  damage_.Clear();
+  full_ = false;
+  return rendered;
+}
+
+void SceneBase::Draw(Surface& surface) const noexcept
+{
+  Repaint(surface, surface.GetClip());
+}
+
+void SceneBase::Repaint(Surface& surface, Rect area) const noexcept
+{
+  const Rect OLD_CLIP = surface.GetClip();
+  area = intersect_rect(area, OLD_CLIP);
+  if (rect_empty(area))
+  {
+    return;
+  }
+
+  // Nodes clear their own box, so the background only needs filling when no visible
+  // node covers the whole area.
+  bool covered = false;
+  for (uint16_t i = 0; i < count_ && !covered; ++i)
+  {
+    covered = nodes_[i].visible && rect_contains(nodes_[i].bounds, area);
+  }
+  surface.SetClip(area);
+  if (!covered)
+  {
+    surface.FillRect(area, background_);
+  }
+  for (uint16_t i = 0; i < count_; ++i)
+  {
+    const Widget& node = nodes_[i];
+    const Rect VISIBLE = intersect_rect(node.bounds, area);
+    if (node.visible && !rect_empty(VISIBLE))
+    {
+      surface.SetClip(VISIBLE);
+      DrawNode(surface, node);
+    }
+  }
+  surface.SetClip(OLD_CLIP);
+}
+
+void SceneBase::DrawNode(Surface& surface, const Widget& node) const noexcept
+{
+  const Rect BOX = node.bounds;
+  surface.FillRect(BOX, background_);
+  switch (node.kind)
+  {
+    case WidgetKind::LABEL:
+      draw_text_box(surface, BOX, static_cast<const char*>(node.data), node.style,
+                    node.align);
+      break;
+    case WidgetKind::VALUE:
+    {
+      char text[VALUE_CHARS];
+      format_value(node.value, node.decimals, static_cast<const char*>(node.data), text,
+                   sizeof(text));
+      draw_text_box(surface, BOX, text, node.style, node.align);
+      break;
+    }
+    case WidgetKind::ICON:
+    {
+      const Point ORIGIN{
+          static_cast<int16_t>(BOX.x + (static_cast<int32_t>(BOX.w) - node.size.w) / 2),
+          static_cast<int16_t>(BOX.y + (static_cast<int32_t>(BOX.h) - node.size.h) / 2)};
+      surface.DrawBitmap(ORIGIN, static_cast<const uint8_t*>(node.data), node.size,
+                         node.style.color, node.style.raster_op);
+      break;
+    }
+    case WidgetKind::BAR:
+    {
+      // 1-pixel outline and gap around the fill when the box is large enough.
+      Rect inner = BOX;
+      if (BOX.w >= 5U && BOX.h >= 5U)
+      {
+        surface.DrawRect(BOX, node.style.color, node.style.raster_op);
+        inner = Rect{static_cast<int16_t>(BOX.x + 2), static_cast<int16_t>(BOX.y + 2),
+                     static_cast<uint16_t>(BOX.w - 4U),
+                     static_cast<uint16_t>(BOX.h - 4U)};
+      }
+      const int64_t RANGE = static_cast<int64_t>(node.max) - node.min;
+      const int64_t FILLED = std::min<int64_t>(
+          std::max<int64_t>(static_cast<int64_t>(node.value) - node.min, 0), RANGE);
+      if (RANGE <= 0)
+      {
+        break;
+      }
+      if (inner.w >= inner.h)
+      {
+        inner.w = static_cast<uint16_t>(inner.w * FILLED / RANGE);
+      }
+      else
+      {
+        // Vertical bars fill from the bottom.
+        const uint16_t HEIGHT = static_cast<uint16_t>(inner.h * FILLED / RANGE);
+        inner.y = static_cast<int16_t>(inner.y + inner.h - HEIGHT);
+        inner.h = HEIGHT;
+      }
+      surface.FillRect(inner, node.style.color, node.style.raster_op);
+      break;
+    }
+    case WidgetKind::LIST:
+      DrawRows(surface, node);
+      break;
+  }
+}
+
+void SceneBase::DrawRows(Surface& surface, const Widget& node) const noexcept
+{
+  const auto* items = static_cast<const char* const*>(node.data);
+  const int32_t PITCH = text_line_pitch(node.style);
+  if (items == nullptr || PITCH <= 0)
+  {
+    return;
+  }
+
+  const int32_t BOTTOM = node.bounds.y + static_cast<int32_t>(node.bounds.h);
+  TextStyle selected = node.style;
+  selected.color = inverse(node.style.color);
+  selected.raster_op = RasterOp::COPY;
+  for (int32_t index = std::max<int32_t>(node.min, 0); index < node.max; ++index)
+  {
+    const Rect ROW = ListRow(node, index);
+    if (ROW.y >= BOTTOM || rect_empty(ROW))
+    {
+      break;
+    }
+    const Point TOP_LEFT{static_cast<int16_t>(node.bounds.x + 1), ROW.y};
+    if (index == node.value)
+    {
+      surface.FillRect(ROW, node.style.color);
+      surface.DrawTextTopLeft(TOP_LEFT, items[index], selected);
+    }
+    else
+    {
+      surface.DrawTextTopLeft(TOP_LEFT, items[index], node.style);
+    }
+  }
+}
+
+}  // namespace MonoGL
+}  // namespace LibXR
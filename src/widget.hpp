@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "surface.hpp"
+
+namespace LibXR
+{
+namespace MonoGL
+{
+
+enum class WidgetKind : uint8_t
+{
+  LABEL,  // Text, aligned in the box and centred vertically.
+  VALUE,  // Fixed-point number with an optional unit.
+  ICON,   // 1bpp bitmap centred in the box.
+  BAR,    // Outlined bar filled in proportion to the value.
+  LIST    // Rows of text with an optional highlighted selection.
+};
+
+using WidgetId = uint16_t;
+constexpr WidgetId INVALID_WIDGET = 0xFFFFU;
+
+// One retained node. Pointers (text, unit, bitmap bits, list items) are stored, not
+// copied, and must stay valid while the node is in a scene.
+struct Widget
+{
+  WidgetKind kind{WidgetKind::LABEL};
+  bool visible{true};
+  TextAlign align{TextAlign::LEFT};
+  uint8_t decimals{0};        // VALUE: digits after the decimal point.
+  Rect bounds{};              // Box the node draws into and clears.
+  TextStyle style{};          // Font and colors; color and raster_op for icons and bars.
+  const void* data{nullptr};  // Label text, value unit, icon bits or list items.
+  Size size{};                // ICON: bitmap size.
+  int32_t value{0};           // VALUE and BAR value, LIST selection (-1 for none).
+  int32_t min{0};             // BAR: empty value. LIST: first row shown.
+  int32_t max{0};             // BAR: full value. LIST: item count.
+};
+
+// Retained widget layer over a Surface. Setters only record the areas that changed, in
+// a DirtyRegion; Render() repaints each of them clipped to itself, so the surface's
+// dirty tracking and PresentFrame() only see those rects. Nodes are painted in the
+// order they were added and may overlap; hidden or moved nodes leave the background.
+class SceneBase
+{
+ public:
+  SceneBase(const SceneBase&) = delete;
+  SceneBase& operator=(const SceneBase&) = delete;
+
+  // Each Add returns INVALID_WIDGET when the scene is full.
+  WidgetId AddLabel(Rect bounds, const char* text, const TextStyle& style,
+                    TextAlign align = TextAlign::LEFT) noexcept;
+  WidgetId AddValue(Rect bounds, int32_t value, uint8_t decimals, const char* unit,
+                    const TextStyle& style, TextAlign align = TextAlign::RIGHT) noexcept;
+  WidgetId AddIcon(Rect bounds, const uint8_t* bits, Size size,
+                   Color color = Color::WHITE) noexcept;
+  WidgetId AddBar(Rect bounds, int32_t value, int32_t min, int32_t max,
+                  Color color = Color::WHITE) noexcept;
+  WidgetId AddList(Rect bounds, const char* const* items, uint16_t count,
+                   const TextStyle& style) noexcept;
+
+  // Setters that do not change anything leave the node clean. Unknown ids and setters
+  // that do not apply to the node's kind are ignored.
+  void SetText(WidgetId id, const char* text) noexcept;
+  void SetValue(WidgetId id, int32_t value) noexcept;
+  void SetBitmap(WidgetId id, const uint8_t* bits) noexcept;
+  void SetItems(WidgetId id, const char* const* items, uint16_t count) noexcept;
+  // Scrolls the list to keep the selection in view; -1 clears it.
+  void SetSelected(WidgetId id, int32_t index) noexcept;
+  void SetBounds(WidgetId id, Rect bounds) noexcept;
+  void SetVisible(WidgetId id, bool visible) noexcept;
+  // Fills the area no node covers and every node's box; repaints everything.
+  void SetBackground(Color color) noexcept;
+  // Repaints the node at the next Render(), e.g. after editing its text in place.
+  void Invalidate(WidgetId id) noexcept;
+  // Repaints area (logical pixels) at the next Render().
+  void Invalidate(Rect area) noexcept { damage_.Add(area); }
+  // Repaints the whole surface at the next Render(), as the first Render() does.
+  void InvalidateAll() noexcept { full_ = true; }
+
+  const Widget* Get(WidgetId id) const noexcept;
+  uint16_t Count() const noexcept { return count_; }
+  uint16_t Capacity() const noexcept { return capacity_; }
+  bool IsDirty() const noexcept { return full_ || !damage_.Empty(); }
+
+  // Repaints every pending area and returns their bounding box.
+  Rect Render(Surface& surface) noexcept;
+  // Paints the whole scene within the surface clip, e.g. once per band from
+  // Present::PresentPages(). Pending areas are kept; Render() after a full Draw()
+  // only repeats work.
+  void Draw(Surface& surface) const noexcept;
+
+ protected:
+  SceneBase() = default;
+
+  // Derived classes own the storage and bind it from their constructor.
+  void BindStorage(Widget* nodes, uint16_t capacity) noexcept;
+
+ private:
+  WidgetId Add(const Widget& node) noexcept;
+  Widget* Find(WidgetId id) noexcept;
+  Rect ListRow(const Widget& node, int32_t index) const noexcept;
+  void Repaint(Surface& surface, Rect area) const noexcept;
+  void DrawNode(Surface& surface, const Widget& node) const noexcept;
+  void DrawRows(Surface& surface, const Widget& node) const noexcept;
+
+  Widget* nodes_{nullptr};
+  uint16_t capacity_{0};
+  uint16_t count_{0};
+  Color background_{Color::BLACK};
+  DirtyRegion damage_{};
+  bool full_{true};
+};
+
+template <uint16_t kWidgets = 16>
+class Scene : public SceneBase
+{
+ public:
+  static_assert(kWidgets > 0, "kWidgets must be greater than 0.");
+
+  Scene() noexcept { BindStorage(storage_.data(), kWidgets); }
+
+ private:
+  std::array<Widget, kWidgets> storage_{};
+};
+
+}  // namespace MonoGL
+}  // namespace LibXR
@@ -0,0 +1,350 @@
+#!/usr/bin/env python3
+"""Converts a BDF font into a MonoGL font header.
+
+  bdf_to_font.py 6x10.bdf -o u8g2_font_6x10_ascii.hpp --name U8G2_FONT_6X10_ASCII
+  bdf_to_font.py unifont.bdf -o unifont_rle.hpp --name UNIFONT --format rle
+  bdf_to_font.py unifont.bdf -o ui_cjk.hpp --name UI_CJK --ranges 32-126 --text strings.txt
+
+--format fixed writes FontFormat::FIXED glyphs (every glyph in the font box, packed by
+row). --format rle writes FontFormat::RLE glyphs cropped to their ink, with their own
+advance and the run widths that give the smallest data.
+
+--ranges and --text select a sparse codepoint set instead of --first..--last. Only the
+glyphs the BDF has are stored, and the header gains a FontRange table.
+"""
+
+import argparse
+import os
+import sys
+
+
+class Glyph:
+    def __init__(self, code):
+        self.code = code
+        self.advance = 0
+        self.width = 0
+        self.height = 0
+        self.x_offset = 0
+        self.y_offset = 0  # BDF: bottom row relative to the baseline, up positive.
+        self.rows = []  # One int per row, bit (width - 1 - x) is pixel x.
+
+
+def parse_bdf(path):
+    font_ascent = None
+    font_descent = None
+    glyphs = {}
+    glyph = None
+    in_bitmap = False
+    with open(path, encoding="latin-1") as src:
+        for raw in src:
+            line = raw.strip()
+            if not line:
+                continue
+            key, _, rest = line.partition(" ")
+            if glyph is None:
+                if key == "FONT_ASCENT":
+                    font_ascent = int(rest)
+                elif key == "FONT_DESCENT":
+                    font_descent = int(rest)
+                elif key == "STARTCHAR":
+                    glyph = Glyph(-1)
+                continue
+            if in_bitmap:
+                if key == "ENDCHAR":
+                    if glyph.code >= 0:
+                        glyphs[glyph.code] = glyph
+                    glyph = None
+                    in_bitmap = False
+                    continue
+                row_bytes = (glyph.width + 7) // 8
+                value = int(line[: row_bytes * 2], 16)
+                glyph.rows.append(value >> (row_bytes * 8 - glyph.width))
+                continue
+            if key == "ENCODING":
+                glyph.code = int(rest.split()[0])
+            elif key == "DWIDTH":
+                glyph.advance = int(rest.split()[0])
+            elif key == "BBX":
+                w, h, xo, yo = (int(v) for v in rest.split())
+                glyph.width, glyph.height, glyph.x_offset, glyph.y_offset = w, h, xo, yo
+            elif key == "BITMAP":
+                in_bitmap = True
+    if font_ascent is None or font_descent is None:
+        sys.exit("%s: missing FONT_ASCENT/FONT_DESCENT" % path)
+    return font_ascent, font_descent, glyphs
+
+
+def pixel(glyph, x, y):
+    return (glyph.rows[y] >> (glyph.width - 1 - x)) & 1
+
+
+def crop(glyph):
+    """Shrinks the box to the set pixels; blank glyphs become 0 x 0."""
+    xs = [x for x in range(glyph.width) for y in range(glyph.height) if pixel(glyph, x, y)]
+    ys = [y for y in range(glyph.height) for x in range(glyph.width) if pixel(glyph, x, y)]
+    if not xs:
+        glyph.width = glyph.height = 0
+        glyph.rows = []
+        return
+    left, right, top, bottom = min(xs), max(xs), min(ys), max(ys)
+    width = right - left + 1
+    rows = []
+    for y in range(top, bottom + 1):
+        rows.append((glyph.rows[y] >> (glyph.width - 1 - right)) & ((1 << width) - 1))
+    glyph.y_offset += glyph.height - 1 - bottom
+    glyph.x_offset += left
+    glyph.width = width
+    glyph.height = bottom - top + 1
+    glyph.rows = rows
+
+
+def runs_of(glyph):
+    """Alternating run lengths of the scan, starting with unset pixels."""
+    runs = [0]
+    current = 0
+    for y in range(glyph.height):
+        for x in range(glyph.width):
+            value = pixel(glyph, x, y)
+            if value != current:
+                runs.append(0)
+                current = value
+            runs[-1] += 1
+    if len(runs) % 2:
+        runs.append(0)
+    return runs
+
+
+def pairs_of(runs, zero_bits, one_bits):
+    max_zero = (1 << zero_bits) - 1
+    max_one = (1 << one_bits) - 1
+    pairs = []
+    for i in range(0, len(runs), 2):
+        zeros, ones = runs[i], runs[i + 1]
+        while zeros > max_zero:
+            pairs.append((max_zero, 0))
+            zeros -= max_zero
+        while ones > max_one:
+            pairs.append((zeros, max_one))
+            zeros = 0
+            ones -= max_one
+        if zeros or ones:
+            pairs.append((zeros, ones))
+    return pairs
+
+
+def encode(glyph, zero_bits, one_bits):
+    """Bit string of the glyph, mirroring the decoder in surface.cpp."""
+    total = glyph.width * glyph.height
+    pairs = pairs_of(runs_of(glyph), zero_bits, one_bits)
+    bits = []
+    pos = 0
+    i = 0
+    while pos < total:
+        zeros, ones = pairs[i]
+        bits.append(format(zeros, "0%db" % zero_bits) if zero_bits else "")
+        bits.append(format(ones, "0%db" % one_bits) if one_bits else "")
+        while True:
+            pos += zeros + ones
+            i += 1
+            if pos >= total:
+                break
+            repeat = i < len(pairs) and pairs[i] == (zeros, ones)
+            bits.append("1" if repeat else "0")
+            if not repeat:
+                break
+    return "".join(bits)
+
+
+def to_bytes(bits):
+    bits += "0" * (-len(bits) % 8)
+    return [int(bits[i : i + 8], 2) for i in range(0, len(bits), 8)]
+
+
+def char_comment(code):
+    if code == ord("\\"):
+        return "'\\\\'"
+    if code == ord("'"):
+        return "'\\''"
+    if 32 <= code < 127:
+        return "'%s'" % chr(code)
+    return "U+%04X" % code
+
+
+def byte_lines(values, indent="    ", per_line=12):
+    return [
+        indent + " ".join("0x%02XU," % v for v in values[i : i + per_line])
+        for i in range(0, len(values), per_line)
+    ]
+
+
+def write_header(out, name, namespace, source, body):
+    out.write("#pragma once\n\n#include <array>\n#include <cstddef>\n#include <cstdint>\n\n")
+    out.write('#include "font.hpp"\n\nnamespace LibXR\n{\nnamespace MonoGL\n{\n')
+    if namespace:
+        out.write("namespace %s\n{\n" % namespace)
+    out.write("\n// Source: %s, exported by tools/bdf_to_font.py.\n" % source)
+    out.write(body)
+    if namespace:
+        out.write("\n}  // namespace %s\n" % namespace)
+    out.write("}  // namespace MonoGL\n}  // namespace LibXR\n")
+
+
+def font_lines(fields):
+    return "".join("    %s,\n" % f for f in fields)
+
+
+def u8(value):
+    return "static_cast<uint8_t>(%dU)" % value
+
+
+def emit_fixed(name, ascent, descent, codes, glyphs):
+    """Arrays and the Font fields that follow the metrics."""
+    # Every glyph is placed in the font box: ascent rows above the baseline.
+    width = max([g.advance for c, g in glyphs.items() if c in codes] + [1])
+    height = ascent + descent
+    row_bytes = (width + 7) // 8
+    lines = []
+    data_count = 0
+    for code in codes:
+        glyph = glyphs.get(code, Glyph(code))
+        box = []
+        for y in range(height):
+            row = 0
+            glyph_y = y - (ascent - glyph.y_offset - glyph.height)
+            if 0 <= glyph_y < glyph.height:
+                for x in range(glyph.width):
+                    box_x = glyph.x_offset + x
+                    if 0 <= box_x < width and pixel(glyph, x, glyph_y):
+                        row |= 1 << (row_bytes * 8 - 1 - box_x)
+            box.extend((row >> (8 * (row_bytes - 1 - i))) & 0xFF for i in range(row_bytes))
+        lines.append("    // %s (%d)" % (char_comment(code), code))
+        lines.extend(byte_lines(box, per_line=row_bytes * height))
+        data_count += len(box)
+    body = "inline constexpr std::array<uint8_t, %dU> %s_GLYPHS{\n" % (data_count, name)
+    body += "\n".join(lines) + "\n};\n\n"
+    return body, width, height, ["%s_GLYPHS.data()" % name, "FontFormat::FIXED",
+                                 "nullptr", u8(0), u8(0)]
+
+
+def emit_rle(name, codes, glyphs):
+    """Arrays and the Font fields that follow the metrics."""
+    cropped = {}
+    for code in codes:
+        glyph = glyphs.get(code, Glyph(code))
+        crop(glyph)
+        cropped[code] = glyph
+
+    best = None
+    for zero_bits in range(1, 9):
+        for one_bits in range(1, 9):
+            size = sum((len(encode(g, zero_bits, one_bits)) + 7) // 8 for g in cropped.values())
+            if best is None or size < best[0]:
+                best = (size, zero_bits, one_bits)
+    _, zero_bits, one_bits = best
+
+    data = []
+    table = []
+    for code in codes:
+        glyph = cropped[code]
+        offset = len(data)
+        data.extend(to_bytes(encode(glyph, zero_bits, one_bits)))
+        if offset > 0xFFFFFF:
+            sys.exit("RLE data exceeds the 24-bit glyph offset")
+        table.append("    FontGlyph{{%dU, %dU, %dU}, %dU, %dU, %d, %d, %dU},  // %s (%d)" % (
+            offset & 0xFF, (offset >> 8) & 0xFF, offset >> 16, glyph.width, glyph.height,
+            glyph.x_offset,
+            glyph.y_offset + glyph.height, glyph.advance, char_comment(code), code))
+    if not data:
+        data = [0]
+
+    width = max(max(max(g.width, g.advance) for g in cropped.values()), 1)
+    height = max(max(g.height for g in cropped.values()), 1)
+    body = "inline constexpr std::array<uint8_t, %dU> %s_RLE_DATA{\n" % (len(data), name)
+    body += "\n".join(byte_lines(data)) + "\n};\n\n"
+    body += "inline constexpr std::array<FontGlyph, %dU> %s_GLYPH_TABLE{{\n" % (
+        len(table), name)
+    body += "\n".join(table) + "\n}};\n\n"
+    return body, width, height, ["%s_RLE_DATA.data()" % name, "FontFormat::RLE",
+                                 "%s_GLYPH_TABLE.data()" % name, u8(zero_bits),
+                                 u8(one_bits)]
+
+
+def parse_ranges(text):
+    codes = set()
+    for part in text.split(","):
+        first, _, last = part.strip().partition("-")
+        first = int(first, 0)
+        last = int(last, 0) if last else first
+        if not 0 <= first <= last <= 0x10FFFF:
+            sys.exit("bad range: %s" % part)
+        codes.update(range(first, last + 1))
+    return codes
+
+
+def ranges_of(codes):
+    """(first, count, glyph_index) runs of consecutive codepoints."""
+    ranges = []
+    for index, code in enumerate(codes):
+        if ranges and ranges[-1][0] + ranges[-1][1] == code and ranges[-1][1] < 0xFFFF:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([code, 1, index])
+    return ranges
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("bdf")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--name", required=True, help="C++ name of the Font object")
+    parser.add_argument("--namespace", default="", help="optional inner namespace")
+    parser.add_argument("--format", choices=("fixed", "rle"), default="rle")
+    parser.add_argument("--first", type=int, default=32)
+    parser.add_argument("--last", type=int, default=126)
+    parser.add_argument("--ranges", help="sparse codepoint set, e.g. 32-126,0x4E00-0x9FFF")
+    parser.add_argument("--text", action="append", default=[],
+                        help="UTF-8 file whose characters are added to the sparse set")
+    args = parser.parse_args()
+
+    ascent, descent, glyphs = parse_bdf(args.bdf)
+    sparse = args.ranges is not None or bool(args.text)
+    if sparse:
+        # Only the glyphs the BDF has are stored; lookups go through FontRange.
+        wanted = parse_ranges(args.ranges) if args.ranges else set()
+        for path in args.text:
+            with open(path, encoding="utf-8") as src:
+                wanted.update(ord(ch) for ch in src.read() if ch not in "\r\n")
+        codes = sorted(c for c in wanted if c in glyphs)
+        if not codes or len(codes) > 0xFFFF:
+            sys.exit("the sparse set must select 1..65535 glyphs of the BDF")
+        source = "%s, %d glyphs" % (os.path.basename(args.bdf), len(codes))
+    else:
+        if not 0 <= args.first <= args.last <= 255:
+            sys.exit("--first/--last must satisfy 0 <= first <= last <= 255")
+        codes = list(range(args.first, args.last + 1))
+        source = "%s, %d..%d" % (os.path.basename(args.bdf), args.first, args.last)
+
+    if args.format == "fixed":
+        body, width, height, fields = emit_fixed(args.name, ascent, descent, codes, glyphs)
+    else:
+        body, width, height, fields = emit_rle(args.name, codes, glyphs)
+
+    first, last = (0, 0) if sparse else (codes[0], codes[-1])
+    fields = [u8(width), u8(height), u8(first), u8(last), u8(ascent), u8(descent)] + fields
+    if sparse:
+        ranges = ranges_of(codes)
+        body += "inline constexpr std::array<FontRange, %dU> %s_RANGES{{\n" % (
+            len(ranges), args.name)
+        body += "".join("    FontRange{0x%04XU, %dU, %dU},\n" % tuple(r) for r in ranges)
+        body += "}};\n\n"
+        fields += ["%s_RANGES.data()" % args.name, "static_cast<uint16_t>(%dU)" % len(ranges)]
+    elif args.format == "fixed":
+        fields = fields[:7]  # Plain FIXED fonts keep the short initializer.
+    body += "inline constexpr Font %s{\n%s};\n" % (args.name, font_lines(fields))
+
+    with open(args.output, "w", newline="\n") as out:
+        write_header(out, args.name, args.namespace, source, body)
+
+
+if __name__ == "__main__":
+    main()